@@ -0,0 +1,67 @@
+#pragma once
+
+/// Standard libraries
+#include <cstdlib>
+#include <new>
+#include <atomic>
+
+/// Counts heap allocations made through the global operator new.  Counting replaces the global allocation
+/// functions, so it is only compiled in when XGAMELIB_COUNT_ALLOCATIONS is defined in exactly one translation
+/// unit before this header is included.
+namespace Allocations
+{
+	/// Gets the running allocation total.
+	///  @returns The allocation counter.
+	static std::atomic<unsigned long>& getCounter(void)
+	{
+		static std::atomic<unsigned long> counter(0);
+		return counter;
+	}
+
+	/// Returns true if allocations are being counted.
+	///  @returns True if counting is compiled in, false otherwise.
+	static bool isCounting(void)
+	{
+#if defined(XGAMELIB_COUNT_ALLOCATIONS)
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	/// Gets the number of allocations made since the application started.
+	///  @returns The allocation count, or zero when counting is not compiled in.
+	static unsigned long getCount(void)
+	{
+		return getCounter().load(std::memory_order_relaxed);
+	}
+}
+
+#if defined(XGAMELIB_COUNT_ALLOCATIONS)
+// the replacements stay out of line, so the compiler pairs each new with a delete rather than malloc with free
+__attribute__((noinline))
+void* operator new(std::size_t size)
+{
+	Allocations::getCounter().fetch_add(1, std::memory_order_relaxed);
+
+	void* memory = std::malloc(size != 0 ? size : 1);
+	if(memory == NULL)
+	{
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+__attribute__((noinline))
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+
+__attribute__((noinline))
+void operator delete(void* memory, std::size_t size) noexcept
+{
+	(void)size;
+	operator delete(memory);
+}
+#endif
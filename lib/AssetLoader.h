@@ -0,0 +1,196 @@
+#pragma once
+
+/// Standard libraries
+#include <cstdlib>
+#include <string>
+#include <deque>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+/// Project components
+#include "TgaDecoder.h"
+
+/// AssetLoader
+///	 Decodes images on a background thread so they are ready before the game asks for them.  The worker only
+///  touches client memory, never Xlib.  The XImage (and any shared memory segment) is created from the decoded
+///  pixels on the game thread: before the render thread starts, or afterwards under the render lock (see
+///  Game::getRenderLock), since the render thread drives the same display connection.
+class AssetLoader
+{
+public:
+	/// Initializes a new instance of AssetLoader.  The worker thread is started by the first request.
+	AssetLoader(void)
+	{
+		stopping = false;
+		pending = 0;
+	}
+
+	/// Disposes of the AssetLoader instance, stopping the worker and releasing unclaimed pixels.
+	~AssetLoader(void)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		queued.notify_all();
+
+		if(worker.joinable())
+		{
+			worker.join();
+		}
+
+		std::map<std::string, Result>::iterator it;
+		for(it = results.begin(); it != results.end(); it++)
+		{
+			free(it->second.pixels);
+		}
+	}
+
+	/// Queues an image to be decoded in the background.  Requesting an image already queued or decoded does nothing.
+	///  @filename Filename of the image, relative to the loader root directory, and including the extension.
+	void request(const char* filename)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if(results.find(filename) != results.end())
+			{
+				return;
+			}
+
+			Result& result = results[filename];
+			result.pixels = NULL;
+			result.width = 0;
+			result.height = 0;
+			result.done = false;
+
+			jobs.push_back(filename);
+			pending++;
+
+			if(!worker.joinable())
+			{
+				worker = std::thread(&AssetLoader::run, this);
+			}
+		}
+		queued.notify_one();
+	}
+
+	/// Hands over the decoded pixels of a requested image, waiting for the worker if it is still being decoded.
+	///  @filename Filename of the image, as it was requested.
+	///  @pixels The BGRA pixels, allocated with malloc and now owned by the caller.
+	///  @width The width of the image.
+	///  @height The height of the image.
+	///  @returns True if the image was requested and decoded, false otherwise.
+	bool take(const char* filename, char** pixels, int* width, int* height)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		std::map<std::string, Result>::iterator it = results.find(filename);
+		if(it == results.end())
+		{
+			return false;
+		}
+
+		while(!it->second.done)
+		{
+			finished.wait(lock);
+		}
+
+		Result result = it->second;
+		results.erase(it);
+		if(result.pixels == NULL)
+		{
+			return false;
+		}
+
+		*pixels = result.pixels;
+		*width = result.width;
+		*height = result.height;
+		return true;
+	}
+
+	/// Gets the number of requested images that have not finished decoding.
+	///  @returns The number of images queued or being decoded.
+	int getPendingCount(void)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return pending;
+	}
+
+private:
+	/// A decoded image waiting to be claimed.  A finished result without pixels could not be decoded.
+	struct Result
+	{
+		char* pixels;
+		int width;
+		int height;
+		bool done;
+	};
+
+	/// The worker loop: decodes queued images until the loader is destroyed.
+	void run(void)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		while(true)
+		{
+			while(!stopping && jobs.empty())
+			{
+				queued.wait(lock);
+			}
+			if(stopping)
+			{
+				return;
+			}
+
+			std::string filename = jobs.front();
+			jobs.pop_front();
+
+			lock.unlock();
+			Result result;
+			decode(filename.c_str(), &result);
+			lock.lock();
+
+			results[filename] = result;
+			pending--;
+			finished.notify_all();
+		}
+	}
+
+	/// Decodes an image into a newly allocated buffer of tightly packed BGRA rows.
+	static void decode(const char* filename, Result* result)
+	{
+		result->pixels = NULL;
+		result->width = 0;
+		result->height = 0;
+		result->done = true;
+
+		TgaDecoder decoder;
+		if(!decoder.open(filename))
+		{
+			return;
+		}
+
+		int stride = decoder.getWidth() * 4;
+		char* pixels = (char*)malloc((size_t)stride * decoder.getHeight());
+		if(pixels == NULL || !decoder.decode(pixels, stride))
+		{
+			free(pixels);
+			return;
+		}
+
+		result->pixels = pixels;
+		result->width = decoder.getWidth();
+		result->height = decoder.getHeight();
+	}
+
+	std::thread worker;
+	std::mutex mutex;
+	std::condition_variable queued;
+	std::condition_variable finished;
+
+	// Images waiting for the worker, and every requested image that has not been claimed
+	std::deque<std::string> jobs;
+	std::map<std::string, Result> results;
+	int pending;
+	bool stopping;
+};
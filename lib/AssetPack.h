@@ -0,0 +1,320 @@
+#pragma once
+
+/// Standard libraries
+#include <stdint.h>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace Constants
+{
+	/// Identifies an asset pack file and its layout version.
+	static const char ASSET_PACK_MAGIC[8] = { 'X', 'G', 'P', 'A', 'C', 'K', 0, 0 };
+	static const uint32_t ASSET_PACK_VERSION = 1;
+
+	/// The pixel layout of packed images: 32 bits per pixel, BGRA in memory (an LSBFirst 0x00RRGGBB ZPixmap).
+	static const uint32_t ASSET_PACK_FORMAT_BGRA32 = 1;
+
+	/// The alignment (in bytes) of each block of pixel and mask data within an asset pack.
+	static const uint32_t ASSET_PACK_ALIGNMENT = 64;
+}
+
+/// AssetPackHeader
+///	 The header at the start of an asset pack, followed by the entry index.
+struct AssetPackHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t format;
+	uint32_t entryCount;
+	uint32_t reserved;
+	uint64_t fileSize;
+};
+
+/// AssetPackEntry
+///	 An image in the asset pack, with the identity of the source file it was built from.  Entries are sorted by name.
+struct AssetPackEntry
+{
+	/// The source path, as passed to XInfo::loadImage
+	char name[96];
+
+	/// The FNV-1a hash of the source file contents, its size and modification time (seconds) when packed
+	uint64_t sourceHash;
+	uint64_t sourceSize;
+	int64_t sourceTime;
+
+	/// The image dimensions
+	uint32_t width;
+	uint32_t height;
+
+	/// The BGRA pixel rows, and the clip mask rows derived from alpha (XBM layout)
+	uint64_t pixelOffset;
+	uint32_t pixelStride;
+	uint32_t maskStride;
+	uint64_t maskOffset;
+};
+
+/// AssetPack
+///	 A read-only, memory-mapped archive of images already converted to the display layout, so images can be
+///  created over the mapping without decoding.  Entries whose source file has changed since packing are
+///  reported as stale so the caller can fall back to the source.
+class AssetPack
+{
+public:
+	/// Initializes a new instance of AssetPack.
+	AssetPack(void)
+	{
+		file = NULL;
+		fileSize = 0;
+		header = NULL;
+		entries = NULL;
+	}
+
+	/// Disposes of the AssetPack instance, unmapping the archive.
+	~AssetPack(void)
+	{
+		close();
+	}
+
+	/// Maps an archive and validates its header and index.
+	///  @filename The path of the asset pack.
+	///  @returns True if the archive is usable, false otherwise.
+	bool open(const char* filename)
+	{
+		close();
+
+		int fd = ::open(filename, O_RDONLY);
+		if(fd < 0)
+		{
+			return false;
+		}
+
+		struct stat info;
+		if(fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(AssetPackHeader))
+		{
+			::close(fd);
+			return false;
+		}
+
+		void* mapping = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		::close(fd);
+		if(mapping == MAP_FAILED)
+		{
+			return false;
+		}
+
+		file = (const char*)mapping;
+		fileSize = info.st_size;
+		header = (const AssetPackHeader*)file;
+		entries = (const AssetPackEntry*)(file + sizeof(AssetPackHeader));
+
+		if(!isValid())
+		{
+			close();
+			return false;
+		}
+		return true;
+	}
+
+	/// Unmaps the archive.
+	void close(void)
+	{
+		if(file != NULL)
+		{
+			munmap((void*)file, fileSize);
+		}
+		file = NULL;
+		fileSize = 0;
+		header = NULL;
+		entries = NULL;
+	}
+
+	/// Returns true if an archive is mapped.
+	///  @returns True if open, false otherwise.
+	bool isOpen(void)
+	{
+		return file != NULL;
+	}
+
+	/// Gets the number of images in the archive.
+	///  @returns The entry count.
+	int getEntryCount(void)
+	{
+		return header != NULL ? header->entryCount : 0;
+	}
+
+	/// Finds the entry of a source path.
+	///  @name The source path.
+	///  @returns The entry, or NULL if the archive does not contain the path.
+	const AssetPackEntry* find(const char* name)
+	{
+		if(header == NULL)
+		{
+			return NULL;
+		}
+
+		int low = 0;
+		int high = (int)header->entryCount - 1;
+		while(low <= high)
+		{
+			int middle = (low + high) / 2;
+			int order = strncmp(entries[middle].name, name, sizeof(entries[middle].name));
+			if(order == 0)
+			{
+				return &entries[middle];
+			}
+			if(order < 0)
+			{
+				low = middle + 1;
+			}
+			else
+			{
+				high = middle - 1;
+			}
+		}
+		return NULL;
+	}
+
+	/// Returns true if the source of an entry is unchanged since it was packed.  The size and modification
+	/// time are checked first; a file with a new time but the same size is re-hashed before it is rejected.
+	///  @entry The entry to check.
+	///  @returns True if the packed image is current, false if it is stale.
+	static bool isCurrent(const AssetPackEntry* entry)
+	{
+		struct stat info;
+		if(stat(entry->name, &info) != 0)
+		{
+			// the source is not shipped, so the pack is authoritative
+			return true;
+		}
+
+		if((uint64_t)info.st_size != entry->sourceSize)
+		{
+			return false;
+		}
+		if((int64_t)info.st_mtime == entry->sourceTime)
+		{
+			return true;
+		}
+
+		uint64_t sourceHash;
+		return hashFile(entry->name, &sourceHash) && sourceHash == entry->sourceHash;
+	}
+
+	/// Gets the pixel rows of an entry.
+	///  @entry The entry.
+	///  @returns The first pixel row.
+	const char* getPixels(const AssetPackEntry* entry)
+	{
+		return file + entry->pixelOffset;
+	}
+
+	/// Gets the clip mask rows of an entry.
+	///  @entry The entry.
+	///  @returns The first mask row.
+	const char* getMask(const AssetPackEntry* entry)
+	{
+		return file + entry->maskOffset;
+	}
+
+	/// Returns true if a pointer lies within the mapped archive.
+	///  @data The pointer to test.
+	///  @returns True if the memory belongs to the archive, false otherwise.
+	bool contains(const void* data)
+	{
+		return file != NULL && (const char*)data >= file && (const char*)data < file + fileSize;
+	}
+
+	/// Computes the 64-bit FNV-1a hash of a block of memory.
+	///  @data The memory to hash.
+	///  @length The number of bytes.
+	///  @returns The hash.
+	static uint64_t hash(const void* data, size_t length)
+	{
+		const unsigned char* bytes = (const unsigned char*)data;
+		uint64_t value = 14695981039346656037ULL;
+		for(size_t i = 0; i < length; i++)
+		{
+			value = (value ^ bytes[i]) * 1099511628211ULL;
+		}
+		return value;
+	}
+
+	/// Computes the hash of a file's contents.
+	///  @filename The path of the file.
+	///  @value The hash of the file.
+	///  @returns True if the file was read, false otherwise.
+	static bool hashFile(const char* filename, uint64_t* value)
+	{
+		int fd = ::open(filename, O_RDONLY);
+		if(fd < 0)
+		{
+			return false;
+		}
+
+		struct stat info;
+		if(fstat(fd, &info) != 0)
+		{
+			::close(fd);
+			return false;
+		}
+
+		if(info.st_size == 0)
+		{
+			::close(fd);
+			*value = hash(NULL, 0);
+			return true;
+		}
+
+		void* mapping = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		::close(fd);
+		if(mapping == MAP_FAILED)
+		{
+			return false;
+		}
+
+		*value = hash(mapping, info.st_size);
+		munmap(mapping, info.st_size);
+		return true;
+	}
+
+private:
+	/// Checks the header, and that the index and every entry's data lie within the file.
+	bool isValid(void)
+	{
+		if(memcmp(header->magic, Constants::ASSET_PACK_MAGIC, sizeof(Constants::ASSET_PACK_MAGIC)) != 0 ||
+			header->version != Constants::ASSET_PACK_VERSION ||
+			header->format != Constants::ASSET_PACK_FORMAT_BGRA32 ||
+			header->fileSize != fileSize)
+		{
+			return false;
+		}
+
+		uint64_t indexEnd = sizeof(AssetPackHeader) + (uint64_t)header->entryCount * sizeof(AssetPackEntry);
+		if(indexEnd > fileSize)
+		{
+			return false;
+		}
+
+		for(uint32_t i = 0; i < header->entryCount; i++)
+		{
+			const AssetPackEntry& entry = entries[i];
+			if(entry.name[sizeof(entry.name) - 1] != 0 ||
+				entry.pixelStride < entry.width * 4 ||
+				entry.maskStride < (entry.width + 7) / 8 ||
+				entry.pixelOffset + (uint64_t)entry.pixelStride * entry.height > fileSize ||
+				entry.maskOffset + (uint64_t)entry.maskStride * entry.height > fileSize)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	const char* file;
+	size_t fileSize;
+	const AssetPackHeader* header;
+	const AssetPackEntry* entries;
+};
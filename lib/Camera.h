@@ -0,0 +1,216 @@
+#pragma once
+
+/// Standard libraries
+#include <cstdlib>
+#include <algorithm>
+
+/// Project components
+#include "MathHelper.h"
+
+/// Camera
+///	 The window onto a world larger than the screen.  The camera follows a target once per simulation step,
+///  moving only as far as needed to keep the target inside a dead zone centred in the view, and never shows
+///  anything beyond the world bounds.  The position used for drawing is interpolated between the last two
+///  steps, like every other moving object, and snapped to whole pixels.
+class Camera
+{
+public:
+	/// Initializes a new instance of Camera.
+	Camera(void)
+	{
+		x = 0;
+		y = 0;
+		previousX = 0;
+		previousY = 0;
+		viewX = 0;
+		viewY = 0;
+		viewWidth = 0;
+		viewHeight = 0;
+		boundsWidth = 0;
+		boundsHeight = 0;
+		deadZoneWidth = 0;
+		deadZoneHeight = 0;
+	}
+
+	/// Sets the size of the view, normally the size of the window.
+	///  @width The width of the view in pixels.
+	///  @height The height of the view in pixels.
+	void setViewport(int width, int height)
+	{
+		viewWidth = width;
+		viewHeight = height;
+	}
+
+	/// Sets the size of the world.  The camera stays at the origin along an axis where the world is smaller
+	/// than the view.
+	///  @width The width of the world in pixels.
+	///  @height The height of the world in pixels.
+	void setBounds(float width, float height)
+	{
+		boundsWidth = width;
+		boundsHeight = height;
+	}
+
+	/// Sets the size of the dead zone, the area in the middle of the view the target can move within without
+	/// scrolling the camera.  A zero size keeps the target centred.
+	///  @width The width of the dead zone in pixels.
+	///  @height The height of the dead zone in pixels.
+	void setDeadZone(float width, float height)
+	{
+		deadZoneWidth = width;
+		deadZoneHeight = height;
+	}
+
+	/// Moves the camera to keep a target inside the dead zone.  Called once per simulation step.
+	///  @left The x-coordinate (in world coordinates) of the target.
+	///  @top The y-coordinate (in world coordinates) of the target.
+	///  @width The width of the target.
+	///  @height The height of the target.
+	void follow(float left, float top, float width, float height)
+	{
+		previousX = x;
+		previousY = y;
+
+		x = clampX(track(x, left, width, viewWidth, deadZoneWidth));
+		y = clampY(track(y, top, height, viewHeight, deadZoneHeight));
+	}
+
+	/// Centres the camera on a target immediately, without interpolating from the previous position.
+	///  @left The x-coordinate (in world coordinates) of the target.
+	///  @top The y-coordinate (in world coordinates) of the target.
+	///  @width The width of the target.
+	///  @height The height of the target.
+	void focus(float left, float top, float width, float height)
+	{
+		x = clampX(left + (width - viewWidth) / 2.0f);
+		y = clampY(top + (height - viewHeight) / 2.0f);
+		previousX = x;
+		previousY = y;
+		viewX = MATH::ifloor(x);
+		viewY = MATH::ifloor(y);
+	}
+
+	/// Sets the position used for drawing this frame.
+	///  @alpha How far the clock has moved past the last simulation step, from 0 to 1.
+	void interpolate(float alpha)
+	{
+		viewX = MATH::ifloor(MATH::lerp(previousX, x, alpha));
+		viewY = MATH::ifloor(MATH::lerp(previousY, y, alpha));
+	}
+
+	/// Gets the left edge of the view for this frame.
+	///  @returns The x-coordinate (in world coordinates) drawn at the left of the screen.
+	int getX(void)
+	{
+		return viewX;
+	}
+
+	/// Gets the top edge of the view for this frame.
+	///  @returns The y-coordinate (in world coordinates) drawn at the top of the screen.
+	int getY(void)
+	{
+		return viewY;
+	}
+
+	/// Gets the width of the view.
+	///  @returns The width in pixels.
+	int getWidth(void)
+	{
+		return viewWidth;
+	}
+
+	/// Gets the height of the view.
+	///  @returns The height in pixels.
+	int getHeight(void)
+	{
+		return viewHeight;
+	}
+
+	/// Gets the area the view can show anywhere between the last two simulation steps.
+	///  @left The left edge (in world coordinates) of the area.
+	///  @top The top edge (in world coordinates) of the area.
+	///  @right One past the right edge of the area.
+	///  @bottom One past the bottom edge of the area.
+	void getStepBounds(int* left, int* top, int* right, int* bottom)
+	{
+		*left = MATH::ifloor(std::min(previousX, x));
+		*top = MATH::ifloor(std::min(previousY, y));
+		*right = MATH::iceiling(std::max(previousX, x)) + viewWidth;
+		*bottom = MATH::iceiling(std::max(previousY, y)) + viewHeight;
+	}
+
+	/// Converts a world x-coordinate to a screen x-coordinate for this frame.
+	///  @worldX The x-coordinate in world coordinates.
+	///  @returns The x-coordinate on screen.
+	int toScreenX(int worldX)
+	{
+		return worldX - viewX;
+	}
+
+	/// Converts a world y-coordinate to a screen y-coordinate for this frame.
+	///  @worldY The y-coordinate in world coordinates.
+	///  @returns The y-coordinate on screen.
+	int toScreenY(int worldY)
+	{
+		return worldY - viewY;
+	}
+
+	/// Returns true if any part of an area is in view this frame.
+	///  @left The x-coordinate (in world coordinates) of the area.
+	///  @top The y-coordinate (in world coordinates) of the area.
+	///  @width The width of the area.
+	///  @height The height of the area.
+	///  @returns True if the area is at least partly visible; false otherwise.
+	bool isVisible(int left, int top, int width, int height)
+	{
+		return left < viewX + viewWidth && left + width > viewX &&
+			top < viewY + viewHeight && top + height > viewY;
+	}
+
+private:
+	/// Moves one axis of the camera as little as possible to keep a span inside the dead zone.  A span that does
+	/// not fit in the dead zone is centred instead, so the camera cannot alternate between its two edges.
+	static float track(float position, float start, float length, int view, float deadZone)
+	{
+		float zone = std::min(deadZone, (float)view);
+		float margin = (view - zone) / 2.0f;
+		if(length >= zone)
+		{
+			return start + (length - view) / 2.0f;
+		}
+
+		// the span may start anywhere in [position + margin, position + view - margin - length]
+		float lowest = start + length - view + margin;
+		float highest = start - margin;
+		return MATH::clamp(position, lowest, highest);
+	}
+
+	/// Keeps the view within the world horizontally.
+	float clampX(float value)
+	{
+		return MATH::clamp(value, 0, std::max(0.0f, boundsWidth - viewWidth));
+	}
+
+	/// Keeps the view within the world vertically.
+	float clampY(float value)
+	{
+		return MATH::clamp(value, 0, std::max(0.0f, boundsHeight - viewHeight));
+	}
+
+	/// The position after the last two simulation steps
+	float x;
+	float y;
+	float previousX;
+	float previousY;
+
+	/// The whole-pixel position drawn this frame
+	int viewX;
+	int viewY;
+
+	int viewWidth;
+	int viewHeight;
+	float boundsWidth;
+	float boundsHeight;
+	float deadZoneWidth;
+	float deadZoneHeight;
+};
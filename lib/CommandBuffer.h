@@ -0,0 +1,300 @@
+#pragma once
+
+/// Standard libraries
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+
+/// X11 libraries
+#include <X11/Xlib.h>
+
+/// Project components
+#include "XInfo.h"
+#include "Spritesheet.h"
+#include "Logger.h"
+
+namespace Constants
+{
+	/// The requests an outlined string costs: a foreground change and eight outline strings, then a foreground
+	/// change and the string itself (see XInfo::renderString).
+	static const int STRING_REQUESTS = 12;
+
+	/// The requests a layer costs: setting its mask and clip origin, the copy and clearing the mask (see
+	/// XInfo::drawLayer).
+	static const int LAYER_REQUESTS = 4;
+}
+
+namespace Logger
+{
+	/// Command Buffer Messages
+	static const char* INFO_REQUESTS_RECORDED = "# Modelled draw requests per frame in recorded order = ";
+	static const char* INFO_REQUESTS_SORTED = "# Modelled draw requests per frame sorted = ";
+	static const char* INFO_REQUESTS_UNCHANGED = "# Sorting saved no modelled requests in this scene";
+}
+
+/// DrawCommand
+///	 A sprite, string or layer draw recorded for the end of the frame.
+struct DrawCommand
+{
+	enum Type { SPRITE, STRING, LAYER };
+
+	Type type;
+	int layer;
+
+	/// The order the command was recorded in, which keeps draws of the same state in order within a layer
+	int sequence;
+
+	/// The clip mask of a sprite, or the pixmap of a layer
+	Pixmap mask;
+	Spritesheet* sheet;
+	int index;
+
+	/// The string, which must live until the buffer is submitted (such as in the frame arena)
+	const char* text;
+	unsigned long colour;
+
+	int x;
+	int y;
+};
+
+/// CommandBuffer
+///	 Records the sprite and string draws of a frame and submits them together, ordered by layer and then by clip
+///  mask and spritesheet, so the clip mask of the sprite graphics context changes once per run of sprites sharing
+///  it instead of around every draw.  Layers are drawn in increasing order; within a layer, only draws that share a
+///  mask and sheet keep the order they were recorded in.  The requests the frame would cost in recorded and
+///  sorted order are estimated for comparison from a model of what each draw sends (see countRequests), not
+///  counted on the display connection.
+class CommandBuffer
+{
+public:
+	/// Initializes a new instance of CommandBuffer.
+	CommandBuffer(void)
+	{
+		recordedRequests = 0;
+		sortedRequests = 0;
+		totalRecorded = 0;
+		totalSorted = 0;
+		frames = 0;
+	}
+
+	/// Records a sprite draw.
+	///  @layer The layer the sprite is drawn on.
+	///  @sheet The spritesheet to draw the sprite from.
+	///  @mask The clip mask of the spritesheet, or None.
+	///  @x The x-coordinate (in screen coordinates) to draw the sprite.
+	///  @y The y-coordinate (in screen coordinates) to draw the sprite.
+	///  @index The index of the sprite in the sheet.
+	void drawSprite(int layer, Spritesheet* sheet, Pixmap mask, int x, int y, int index)
+	{
+		DrawCommand command;
+		command.type = DrawCommand::SPRITE;
+		command.layer = layer;
+		command.sequence = commands.size();
+		command.mask = mask;
+		command.sheet = sheet;
+		command.index = index;
+		command.text = NULL;
+		command.colour = 0;
+		command.x = x;
+		command.y = y;
+		commands.push_back(command);
+	}
+
+	/// Records an outlined string draw.
+	///  @layer The layer the string is drawn on.
+	///  @text The string, which must live until the buffer is submitted.
+	///  @x The x-coordinate (in screen coordinates) of the string.
+	///  @y The y-coordinate (in screen coordinates) of the baseline.
+	///  @colour The color of the string.
+	void drawString(int layer, const char* text, int x, int y, unsigned long colour)
+	{
+		DrawCommand command;
+		command.type = DrawCommand::STRING;
+		command.layer = layer;
+		command.sequence = commands.size();
+		command.mask = None;
+		command.sheet = NULL;
+		command.index = 0;
+		command.text = text;
+		command.colour = colour;
+		command.x = x;
+		command.y = y;
+		commands.push_back(command);
+	}
+
+	/// Records a layer draw (see XInfo::createLayer).
+	///  @layer The layer the off-screen layer is drawn on.
+	///  @pxm The pixmap of the off-screen layer.
+	///  @x The x-coordinate (in screen coordinates) of the off-screen layer.
+	///  @y The y-coordinate (in screen coordinates) of the off-screen layer.
+	void drawLayer(int layer, Pixmap pxm, int x, int y)
+	{
+		DrawCommand command;
+		command.type = DrawCommand::LAYER;
+		command.layer = layer;
+		command.sequence = commands.size();
+		command.mask = pxm;
+		command.sheet = NULL;
+		command.index = 0;
+		command.text = NULL;
+		command.colour = 0;
+		command.x = x;
+		command.y = y;
+		commands.push_back(command);
+	}
+
+	/// Sorts and draws the recorded commands, then empties the buffer for the next frame.
+	///  @xinfo The graphics information for game.
+	void submit(XInfo* xinfo)
+	{
+		recordedRequests = countRequests(true);
+		std::sort(commands.begin(), commands.end(), compareCommands);
+		sortedRequests = countRequests(false);
+
+		totalRecorded += recordedRequests;
+		totalSorted += sortedRequests;
+		frames++;
+
+		Pixmap mask = None;
+		for(size_t i = 0; i < commands.size(); i++)
+		{
+			const DrawCommand& command = commands[i];
+			if(command.type == DrawCommand::STRING)
+			{
+				xinfo->drawString(command.text, command.x, command.y, command.colour);
+				continue;
+			}
+			if(command.type == DrawCommand::LAYER)
+			{
+				// the layer is copied through a mask of its own, which is cleared afterwards
+				xinfo->drawLayer(command.mask, command.x, command.y);
+				mask = None;
+				continue;
+			}
+
+			if(command.mask != mask)
+			{
+				mask = command.mask;
+				xinfo->setMask(mask);
+			}
+			xinfo->draw(command.sheet, command.x, command.y, command.index);
+		}
+
+		// other draws to the sprite graphics context expect no clip mask
+		if(mask != None)
+		{
+			xinfo->clearMask();
+		}
+		commands.clear();
+	}
+
+	/// Gets the number of commands recorded since the last submit.
+	///  @returns The command count.
+	int getCount(void)
+	{
+		return commands.size();
+	}
+
+	/// Gets the modelled requests the last frame would have cost drawn in the order it was recorded.
+	///  @returns The request count.
+	long getRecordedRequests(void)
+	{
+		return recordedRequests;
+	}
+
+	/// Gets the modelled requests the last frame cost once sorted.
+	///  @returns The request count.
+	long getSortedRequests(void)
+	{
+		return sortedRequests;
+	}
+
+	/// Reports the average modelled requests per frame, in recorded and sorted order, of every frame submitted.
+	void report(void)
+	{
+		long count = frames > 0 ? frames : 1;
+		Logger::application_info(Logger::INFO_REQUESTS_RECORDED, totalRecorded / count);
+		Logger::application_info(Logger::INFO_REQUESTS_SORTED, totalSorted / count);
+		if(totalRecorded == totalSorted)
+		{
+			Logger::application_info(Logger::INFO_REQUESTS_UNCHANGED);
+		}
+	}
+
+private:
+	/// Orders commands by layer, then clip mask, then spritesheet, then the order they were recorded in.
+	static bool compareCommands(const DrawCommand& a, const DrawCommand& b)
+	{
+		if(a.layer != b.layer)
+		{
+			return a.layer < b.layer;
+		}
+		if(a.mask != b.mask)
+		{
+			return a.mask < b.mask;
+		}
+		if(a.sheet != b.sheet)
+		{
+			return a.sheet < b.sheet;
+		}
+		return a.sequence < b.sequence;
+	}
+
+	/// Estimates the requests drawing the commands in their current order costs: a clip mask change whenever the
+	/// mask differs from the previous sprite's, a clip origin for each masked sprite and a copy or upload for each sprite.
+	///  @bracketed True to also clear the mask after each run of sprites sharing it, as draws made directly
+	///  bracket their sprites with XInfo::setMask and XInfo::clearMask.
+	long countRequests(bool bracketed)
+	{
+		long requests = 0;
+		Pixmap mask = None;
+		for(size_t i = 0; i < commands.size(); i++)
+		{
+			const DrawCommand& command = commands[i];
+			if(command.type == DrawCommand::STRING)
+			{
+				requests += Constants::STRING_REQUESTS;
+				continue;
+			}
+			if(command.type == DrawCommand::LAYER)
+			{
+				if(bracketed && mask != None)
+				{
+					requests++;
+				}
+				requests += Constants::LAYER_REQUESTS;
+				mask = None;
+				continue;
+			}
+
+			if(command.mask != mask)
+			{
+				if(bracketed && mask != None && command.mask != None)
+				{
+					requests++;
+				}
+				mask = command.mask;
+				requests++;
+			}
+			if(mask != None)
+			{
+				requests++;
+			}
+			requests++;
+		}
+		if(mask != None)
+		{
+			requests++;
+		}
+		return requests;
+	}
+
+	std::vector<DrawCommand> commands;
+
+	/// The requests of the last frame, and the totals over every frame
+	long recordedRequests;
+	long sortedRequests;
+	long totalRecorded;
+	long totalSorted;
+	long frames;
+};
@@ -0,0 +1,360 @@
+#pragma once
+
+/// Standard libraries
+#include <stdint.h>
+#include <stdlib.h>
+#include <cstring>
+#include <algorithm>
+
+/// SIMD intrinsics
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define XGAMELIB_X86 1
+#endif
+
+/// X11/XLib libraries
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+
+namespace Constants
+{
+	/// Determines if sprites are alpha blended into a client-side framebuffer instead of drawn with clip masks.
+	static bool USE_COMPOSITOR = false;
+}
+
+/// Contains the alpha blending kernels of the software compositor.  Pixels are 32-bit BGRA in memory
+/// (0xAARRGGBB when read as a little-endian word) with straight, non-premultiplied alpha.
+namespace Blend
+{
+	/// Blends a row of source pixels over destination pixels.
+	typedef void (*BlendRow)(uint32_t* dst, const uint32_t* src, int count);
+
+	/// Blends a single pixel: dst + (src - dst) * alpha / 255, per channel.
+	///  @dst The destination pixel.
+	///  @src The source pixel.
+	///  @returns The blended pixel.
+	static inline uint32_t blendPixel(uint32_t dst, uint32_t src)
+	{
+		uint32_t alpha = src >> 24;
+		if(alpha == 0xFF)
+		{
+			return src;
+		}
+		if(alpha == 0)
+		{
+			return dst;
+		}
+
+		uint32_t inverse = 255 - alpha;
+		uint32_t result = 0;
+		for(int shift = 0; shift < 32; shift += 8)
+		{
+			uint32_t t = ((src >> shift) & 0xFF) * alpha + ((dst >> shift) & 0xFF) * inverse + 128;
+			result |= (((t + (t >> 8)) >> 8) & 0xFF) << shift;
+		}
+		return result;
+	}
+
+	/// Blends a row of pixels one at a time.
+	static void blendRowScalar(uint32_t* dst, const uint32_t* src, int count)
+	{
+		for(int i = 0; i < count; i++)
+		{
+			dst[i] = blendPixel(dst[i], src[i]);
+		}
+	}
+
+#if defined(__SSE2__)
+	/// Blends the unpacked (16-bit per channel) halves of four pixels.
+	static inline __m128i blendHalf128(__m128i s, __m128i d)
+	{
+		__m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+		__m128i inverse = _mm_sub_epi16(_mm_set1_epi16(255), alpha);
+
+		__m128i t = _mm_add_epi16(_mm_mullo_epi16(s, alpha), _mm_mullo_epi16(d, inverse));
+		t = _mm_add_epi16(t, _mm_set1_epi16(128));
+		return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+	}
+
+	/// Blends a row of pixels four at a time, skipping fully transparent and copying fully opaque groups.
+	static void blendRowSSE2(uint32_t* dst, const uint32_t* src, int count)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i alphaMask = _mm_set1_epi32(0xFF000000);
+
+		int i = 0;
+		for(; i + 4 <= count; i += 4)
+		{
+			__m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+			__m128i a = _mm_and_si128(s, alphaMask);
+
+			if(_mm_movemask_epi8(_mm_cmpeq_epi32(a, zero)) == 0xFFFF)
+			{
+				continue;
+			}
+			if(_mm_movemask_epi8(_mm_cmpeq_epi32(a, alphaMask)) == 0xFFFF)
+			{
+				_mm_storeu_si128((__m128i*)(dst + i), s);
+				continue;
+			}
+
+			__m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+			__m128i lo = blendHalf128(_mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi8(d, zero));
+			__m128i hi = blendHalf128(_mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi8(d, zero));
+			_mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(lo, hi));
+		}
+
+		blendRowScalar(dst + i, src + i, count - i);
+	}
+#endif
+
+#if defined(XGAMELIB_X86) && (defined(__GNUC__) || defined(__clang__))
+	/// Blends the unpacked (16-bit per channel) halves of eight pixels.
+	__attribute__((target("avx2")))
+	static inline __m256i blendHalf256(__m256i s, __m256i d)
+	{
+		__m256i alpha = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+		__m256i inverse = _mm256_sub_epi16(_mm256_set1_epi16(255), alpha);
+
+		__m256i t = _mm256_add_epi16(_mm256_mullo_epi16(s, alpha), _mm256_mullo_epi16(d, inverse));
+		t = _mm256_add_epi16(t, _mm256_set1_epi16(128));
+		return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+	}
+
+	/// Blends a row of pixels eight at a time, skipping fully transparent and copying fully opaque groups.
+	__attribute__((target("avx2")))
+	static void blendRowAVX2(uint32_t* dst, const uint32_t* src, int count)
+	{
+		const __m256i zero = _mm256_setzero_si256();
+		const __m256i alphaMask = _mm256_set1_epi32(0xFF000000);
+
+		int i = 0;
+		for(; i + 8 <= count; i += 8)
+		{
+			__m256i s = _mm256_loadu_si256((const __m256i*)(src + i));
+			__m256i a = _mm256_and_si256(s, alphaMask);
+
+			if(_mm256_movemask_epi8(_mm256_cmpeq_epi32(a, zero)) == -1)
+			{
+				continue;
+			}
+			if(_mm256_movemask_epi8(_mm256_cmpeq_epi32(a, alphaMask)) == -1)
+			{
+				_mm256_storeu_si256((__m256i*)(dst + i), s);
+				continue;
+			}
+
+			// unpacking and packing both work within 128-bit lanes, so pixel order is preserved
+			__m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));
+			__m256i lo = blendHalf256(_mm256_unpacklo_epi8(s, zero), _mm256_unpacklo_epi8(d, zero));
+			__m256i hi = blendHalf256(_mm256_unpackhi_epi8(s, zero), _mm256_unpackhi_epi8(d, zero));
+			_mm256_storeu_si256((__m256i*)(dst + i), _mm256_packus_epi16(lo, hi));
+		}
+
+		blendRowScalar(dst + i, src + i, count - i);
+	}
+#define XGAMELIB_AVX2 1
+#endif
+
+	/// Returns the name of the fastest kernel the CPU supports.
+	///  @returns The kernel name.
+	static const char* getKernelName(void)
+	{
+#if defined(XGAMELIB_AVX2)
+		if(__builtin_cpu_supports("avx2"))
+		{
+			return "avx2";
+		}
+#endif
+#if defined(__SSE2__)
+		return "sse2";
+#else
+		return "scalar";
+#endif
+	}
+
+	/// Selects the fastest kernel the CPU supports.
+	///  @returns The row blending kernel.
+	static BlendRow selectKernel(void)
+	{
+#if defined(XGAMELIB_AVX2)
+		if(__builtin_cpu_supports("avx2"))
+		{
+			return blendRowAVX2;
+		}
+#endif
+#if defined(__SSE2__)
+		return blendRowSSE2;
+#else
+		return blendRowScalar;
+#endif
+	}
+}
+
+/// Surface
+///	 A client-side 32-bit BGRA pixel buffer that images are copied and alpha blended into.
+class Surface
+{
+public:
+	/// Creates a surface that owns its pixels.
+	///  @surfaceWidth The width of the surface.
+	///  @surfaceHeight The height of the surface.
+	Surface(int surfaceWidth, int surfaceHeight)
+	{
+		void* memory = NULL;
+		if(posix_memalign(&memory, 32, (size_t)surfaceWidth * surfaceHeight * 4) != 0)
+		{
+			memory = NULL;
+		}
+
+		pixels = (uint32_t*)memory;
+		width = surfaceWidth;
+		height = surfaceHeight;
+		stride = surfaceWidth;
+		owned = true;
+		kernel = Blend::selectKernel();
+
+		fill(0, 0, width, height, 0xFF000000);
+	}
+
+	/// Creates a surface over the pixels of an image.
+	///  @img The 32 bits per pixel image to draw into.
+	Surface(XImage* img)
+	{
+		pixels = (uint32_t*)img->data;
+		width = img->width;
+		height = img->height;
+		stride = img->bytes_per_line / 4;
+		owned = false;
+		kernel = Blend::selectKernel();
+	}
+
+	/// Disposes of the Surface instance.
+	~Surface(void)
+	{
+		if(owned)
+		{
+			free(pixels);
+		}
+	}
+
+	/// Fills a region with a colour.
+	///  @x The x-coordinate of the region.
+	///  @y The y-coordinate of the region.
+	///  @w The width of the region.
+	///  @h The height of the region.
+	///  @colour The BGRA colour to fill with.
+	void fill(int x, int y, int w, int h, uint32_t colour)
+	{
+		if(!clip(&x, &y, &w, &h))
+		{
+			return;
+		}
+
+		for(int row = 0; row < h; row++)
+		{
+			uint32_t* dst = pixels + (y + row) * stride + x;
+			std::fill(dst, dst + w, colour);
+		}
+	}
+
+	/// Copies a region of another surface, ignoring alpha.
+	///  @src The surface to copy from.
+	///  @srcx The x-coordinate (in source coordinates) of the region.
+	///  @srcy The y-coordinate (in source coordinates) of the region.
+	///  @w The width of the region.
+	///  @h The height of the region.
+	///  @x The x-coordinate (in surface coordinates) to copy to.
+	///  @y The y-coordinate (in surface coordinates) to copy to.
+	void copy(Surface* src, int srcx, int srcy, int w, int h, int x, int y)
+	{
+		if(!clipSource(src->width, src->height, &srcx, &srcy, &w, &h, &x, &y))
+		{
+			return;
+		}
+
+		for(int row = 0; row < h; row++)
+		{
+			memcpy(pixels + (y + row) * stride + x, src->pixels + (srcy + row) * src->stride + srcx, w * 4);
+		}
+	}
+
+	/// Alpha blends a region of an image over the surface.
+	///  @img The 32 bits per pixel BGRA image to blend.
+	///  @srcx The x-coordinate (in image coordinates) of the region.
+	///  @srcy The y-coordinate (in image coordinates) of the region.
+	///  @w The width of the region.
+	///  @h The height of the region.
+	///  @x The x-coordinate (in surface coordinates) to blend to.
+	///  @y The y-coordinate (in surface coordinates) to blend to.
+	void blend(XImage* img, int srcx, int srcy, int w, int h, int x, int y)
+	{
+		if(!clipSource(img->width, img->height, &srcx, &srcy, &w, &h, &x, &y))
+		{
+			return;
+		}
+
+		const uint32_t* src = (const uint32_t*)img->data;
+		int srcStride = img->bytes_per_line / 4;
+
+		for(int row = 0; row < h; row++)
+		{
+			kernel(pixels + (y + row) * stride + x, src + (srcy + row) * srcStride + srcx, w);
+		}
+	}
+
+	/// Gets the width of the surface.
+	///  @returns The surface width.
+	int getWidth(void)
+	{
+		return width;
+	}
+
+	/// Gets the height of the surface.
+	///  @returns The surface height.
+	int getHeight(void)
+	{
+		return height;
+	}
+
+private:
+	/// Clips a region to the surface, returning false if nothing remains.
+	bool clip(int* x, int* y, int* w, int* h)
+	{
+		int left = std::max(*x, 0);
+		int top = std::max(*y, 0);
+		int right = std::min(*x + *w, width);
+		int bottom = std::min(*y + *h, height);
+
+		*x = left;
+		*y = top;
+		*w = right - left;
+		*h = bottom - top;
+		return *w > 0 && *h > 0;
+	}
+
+	/// Clips a copied region to both the source and the surface, returning false if nothing remains.
+	bool clipSource(int srcWidth, int srcHeight, int* srcx, int* srcy, int* w, int* h, int* x, int* y)
+	{
+		// clip against the source bounds
+		if(*srcx < 0) { *x -= *srcx; *w += *srcx; *srcx = 0; }
+		if(*srcy < 0) { *y -= *srcy; *h += *srcy; *srcy = 0; }
+		*w = std::min(*w, srcWidth - *srcx);
+		*h = std::min(*h, srcHeight - *srcy);
+
+		// clip against the surface bounds
+		if(*x < 0) { *srcx -= *x; *w += *x; *x = 0; }
+		if(*y < 0) { *srcy -= *y; *h += *y; *y = 0; }
+		*w = std::min(*w, width - *x);
+		*h = std::min(*h, height - *y);
+
+		return *w > 0 && *h > 0;
+	}
+
+	uint32_t* pixels;
+	int width;
+	int height;
+	int stride;
+	bool owned;
+	Blend::BlendRow kernel;
+};
@@ -10,12 +10,27 @@
 /// Contains standard constants for the XPlatformer game and associated files.
 namespace Constants
 {
-	/// Divisors for reducing time to miliseconds.
-	static const float TIME_DIVISOR = 100.0f;
+	/// Divisor for reducing nanoseconds to the tenths of a second used by game physics.
+	static const float TIME_DIVISOR = 100000000.0f;
+
+	/// The number of nanoseconds in a second.
+	static const unsigned long NANOS_PER_SECOND = 1000000000UL;
+
+	/// The number of nanoseconds in a microsecond.
+	static const unsigned long NANOS_PER_MICRO = 1000UL;
+
+	/// The number of nanoseconds in a millisecond.
+	static const unsigned long NANOS_PER_MILLI = 1000000UL;
+
+	/// The longest frame the simulation will catch up on, in nanoseconds. Longer stalls are dropped.
+	static const unsigned long MAX_FRAME_TIME = 250000000UL;
 
 	/// The length of the keys count.
 	static const int KEY_COUNT = 8;
 	
 	/// The default FPS of the platformer game.
 	static int DEFAULT_FPS = 30;
+
+	/// The default number of simulation updates per second of the platformer game.
+	static int DEFAULT_TICK_RATE = 30;
 }
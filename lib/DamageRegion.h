@@ -0,0 +1,205 @@
+#pragma once
+
+/// Standard libraries
+#include <vector>
+#include <algorithm>
+
+/// X11/XLib libraries
+#include <X11/Xlib.h>
+
+namespace Constants
+{
+	/// The area (in pixels) two damaged rectangles may waste when merged into their bounding box.
+	static const long DAMAGE_MERGE_SLACK = 64 * 64;
+
+	/// The number of damaged rectangles beyond which the region collapses to its bounding box.
+	static const size_t DAMAGE_MAX_RECTANGLES = 32;
+}
+
+/// DamageRegion
+///	 A set of rectangles that have changed within a surface.  Rectangles are clipped to the surface
+///  bounds, and merged into their bounding box when that costs little extra area.
+class DamageRegion
+{
+public:
+	/// Initializes a new instance of DamageRegion.
+	DamageRegion(void)
+	{
+		width = 0;
+		height = 0;
+		full = false;
+	}
+
+	/// Sets the bounds of the surface the damage is recorded against.
+	///  @surfaceWidth The width of the surface.
+	///  @surfaceHeight The height of the surface.
+	void setBounds(int surfaceWidth, int surfaceHeight)
+	{
+		width = surfaceWidth;
+		height = surfaceHeight;
+	}
+
+	/// Adds a damaged rectangle.
+	///  @x The x-coordinate of the rectangle.
+	///  @y The y-coordinate of the rectangle.
+	///  @w The width of the rectangle.
+	///  @h The height of the rectangle.
+	void add(int x, int y, int w, int h)
+	{
+		if(full)
+		{
+			return;
+		}
+
+		int left = std::max(x, 0);
+		int top = std::max(y, 0);
+		int right = std::min(x + w, width);
+		int bottom = std::min(y + h, height);
+		if(right <= left || bottom <= top)
+		{
+			return;
+		}
+
+		XRectangle rect;
+		rect.x = left;
+		rect.y = top;
+		rect.width = right - left;
+		rect.height = bottom - top;
+		rectangles.push_back(rect);
+	}
+
+	/// Adds every rectangle of another region.
+	///  @other The region to add.
+	void add(DamageRegion& other)
+	{
+		if(other.isFull())
+		{
+			addAll();
+			return;
+		}
+
+		for(size_t i = 0; i < other.rectangles.size(); i++)
+		{
+			XRectangle& rect = other.rectangles[i];
+			add(rect.x, rect.y, rect.width, rect.height);
+		}
+	}
+
+	/// Marks the whole surface as damaged.
+	void addAll(void)
+	{
+		full = true;
+		rectangles.clear();
+
+		XRectangle rect;
+		rect.x = 0;
+		rect.y = 0;
+		rect.width = width;
+		rect.height = height;
+		rectangles.push_back(rect);
+	}
+
+	/// Merges rectangles whose bounding box wastes little area, collapsing to a single box if too many remain.
+	void merge(void)
+	{
+		bool merged = true;
+		while(merged)
+		{
+			merged = false;
+			for(size_t i = 0; i < rectangles.size(); i++)
+			{
+				for(size_t j = i + 1; j < rectangles.size(); j++)
+				{
+					XRectangle box = getBounds(rectangles[i], rectangles[j]);
+					if(getArea(box) <= getArea(rectangles[i]) + getArea(rectangles[j]) + Constants::DAMAGE_MERGE_SLACK)
+					{
+						rectangles[i] = box;
+						rectangles[j] = rectangles.back();
+						rectangles.pop_back();
+						merged = true;
+						j = i;
+					}
+				}
+			}
+		}
+
+		if(rectangles.size() > Constants::DAMAGE_MAX_RECTANGLES)
+		{
+			XRectangle box = rectangles[0];
+			for(size_t i = 1; i < rectangles.size(); i++)
+			{
+				box = getBounds(box, rectangles[i]);
+			}
+			rectangles.clear();
+			rectangles.push_back(box);
+		}
+	}
+
+	/// Removes all damage.
+	void clear(void)
+	{
+		full = false;
+		rectangles.clear();
+	}
+
+	/// Returns true if the whole surface is damaged.
+	///  @returns True if fully damaged, false otherwise.
+	bool isFull(void)
+	{
+		return full;
+	}
+
+	/// Returns true if nothing is damaged.
+	///  @returns True if there is no damage, false otherwise.
+	bool isEmpty(void)
+	{
+		return rectangles.empty();
+	}
+
+	/// Gets the damaged rectangles.
+	///  @returns The damaged rectangles.
+	std::vector<XRectangle>& getRectangles(void)
+	{
+		return rectangles;
+	}
+
+	/// Gets the total area of the damaged rectangles.
+	///  @returns The damaged area in pixels.
+	long getArea(void)
+	{
+		long area = 0;
+		for(size_t i = 0; i < rectangles.size(); i++)
+		{
+			area += getArea(rectangles[i]);
+		}
+		return area;
+	}
+
+private:
+	/// Returns the area of a rectangle.
+	static long getArea(const XRectangle& rect)
+	{
+		return (long)rect.width * rect.height;
+	}
+
+	/// Returns the bounding box of two rectangles.
+	static XRectangle getBounds(const XRectangle& a, const XRectangle& b)
+	{
+		int left = std::min(a.x, b.x);
+		int top = std::min(a.y, b.y);
+		int right = std::max(a.x + a.width, b.x + b.width);
+		int bottom = std::max(a.y + a.height, b.y + b.height);
+
+		XRectangle box;
+		box.x = left;
+		box.y = top;
+		box.width = right - left;
+		box.height = bottom - top;
+		return box;
+	}
+
+	std::vector<XRectangle> rectangles;
+	int width;
+	int height;
+	bool full;
+};
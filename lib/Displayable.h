@@ -7,6 +7,16 @@
 /// Project components
 #include "XInfo.h"
 #include "GameTime.h"
+#include "FrameArena.h"
+#include "Camera.h"
+#include "CommandBuffer.h"
+#include "TripleBuffer.h"
+
+namespace Constants
+{
+	/// The access of a component that has not declared what it uses, conflicting with every other component.
+	static const unsigned int ACCESS_ALL = 0xFFFFFFFF;
+}
 
 /// Displayable
 ///	 Displayable is the base class for an object that can be updated/drawn to the screen.  It includes
@@ -14,7 +24,19 @@
 class Displayable
 {
 public:
-	/// Draws the Displayable component to the screen.
+	/// Initializes a new instance of Displayable.
+	Displayable(void)
+	{
+		frameArena = NULL;
+		camera = NULL;
+		view = NULL;
+		snapshots = NULL;
+		commandBuffer = NULL;
+	}
+
+	/// Draws the Displayable component to the screen.  Drawing may run on a thread of its own while the game
+	/// updates (see Constants::USE_RENDER_THREAD), so it reads only loaded resources and the snapshot slot
+	/// getDrawSlot names.
 	///  @xinfo The graphics information for game.
 	///  @gameTime Time elapsed since the last call to draw.
 	virtual void draw(XInfo* xinfo, GameTime* gameTime) = 0;
@@ -35,4 +57,115 @@ public:
 	/// Initializes required services and loads any non-graphics resources.
 	///  @xinfo The graphics information for game.
 	virtual void initialize(XInfo* xinfo) = 0;
+
+	/// Copies the state draw reads into a snapshot slot.  Called on the game thread after the updates of a frame.
+	///  @slot The slot to fill, from 0 to Constants::TRIPLE_BUFFER_SLOTS - 1.
+	virtual void publish(int slot)
+	{
+	}
+
+	/// Gets the name used to report the component, such as in the frame profiler.
+	///  @returns The name of the component.
+	virtual const char* getName(void)
+	{
+		return "Displayable";
+	}
+
+	/// Gets the shared state the component reads while updating, as bits defined by the game.  Components whose
+	/// updates do not write state the other reads or writes may be updated at the same time.
+	///  @returns The bits of the state read by update.
+	virtual unsigned int getUpdateReads(void)
+	{
+		return Constants::ACCESS_ALL;
+	}
+
+	/// Gets the shared state the component writes while updating, as bits defined by the game.
+	///  @returns The bits of the state written by update.
+	virtual unsigned int getUpdateWrites(void)
+	{
+		return Constants::ACCESS_ALL;
+	}
+
+	/// Returns true if the updates of two components may not run at the same time.
+	///  @other The other component.
+	///  @returns True if either component writes state the other reads or writes; false otherwise.
+	bool conflictsWith(Displayable* other)
+	{
+		return (getUpdateWrites() & (other->getUpdateReads() | other->getUpdateWrites())) != 0 ||
+			(other->getUpdateWrites() & getUpdateReads()) != 0;
+	}
+
+	/// Sets the arena for objects that only live until the end of the frame.
+	///  @arena The frame arena of the game.
+	void setFrameArena(FrameArena* arena)
+	{
+		frameArena = arena;
+	}
+
+	/// Sets the camera the component follows while updating.
+	///  @follower The camera of the game.
+	void setCamera(Camera* follower)
+	{
+		camera = follower;
+	}
+
+	/// Sets the camera the component draws through and the snapshots it draws from.
+	///  @drawn The copy of the camera published with the snapshot being drawn.
+	///  @buffer The slots of the game's snapshots.
+	void setView(Camera* drawn, TripleBuffer* buffer)
+	{
+		view = drawn;
+		snapshots = buffer;
+	}
+
+	/// Sets the buffer the component records its sprite draws into.
+	///  @buffer The command buffer of the game.
+	void setCommandBuffer(CommandBuffer* buffer)
+	{
+		commandBuffer = buffer;
+	}
+
+protected:
+	/// Gets the arena for objects that only live until the end of the frame.
+	///  @returns The frame arena of the game.
+	FrameArena* getFrameArena(void)
+	{
+		return frameArena;
+	}
+
+	/// Gets the camera the component follows while updating.
+	///  @returns The camera of the game.
+	Camera* getCamera(void)
+	{
+		return camera;
+	}
+
+	/// Gets the camera the component draws through, as published with the snapshot being drawn and interpolated
+	/// for the frame.
+	///  @returns The camera for drawing.
+	Camera* getView(void)
+	{
+		return view;
+	}
+
+	/// Gets the snapshot slot draw reads from.
+	///  @returns The slot last filled by publish that is being drawn.
+	int getDrawSlot(void)
+	{
+		return snapshots->getFront();
+	}
+
+	/// Gets the buffer the component records its sprite draws into, submitted once every component has drawn.
+	///  @returns The command buffer of the game.
+	CommandBuffer* getCommandBuffer(void)
+	{
+		return commandBuffer;
+	}
+
+private:
+	FrameArena* frameArena;
+	Camera* camera;
+	Camera* view;
+	TripleBuffer* snapshots;
+	CommandBuffer* commandBuffer;
 };
@@ -0,0 +1,408 @@
+#pragma once
+
+/// Standard libraries
+#include <cstdlib>
+#include <stdint.h>
+#include <vector>
+
+/// Project components
+#include "XInfo.h"
+#include "Spritesheet.h"
+#include "CommandBuffer.h"
+#include "MathHelper.h"
+
+/// The components an entity can have, as bits of its component mask.
+enum COMPONENT
+{
+	/// A position, and the position before the last update (EntityStore::getX/getY, getPreviousX/getPreviousY).
+	COMPONENT_POSITION = 1 << 0,
+
+	/// A velocity in pixels per unit of elapsed time (EntityStore::getVelocityX/getVelocityY).
+	COMPONENT_VELOCITY = 1 << 1,
+
+	/// An axis-aligned box at the position (EntityStore::getWidth/getHeight).
+	COMPONENT_BOUNDS = 1 << 2,
+
+	/// A sprite drawn at the position, optionally cycling through a range of frames (EntityStore::getFrame).
+	COMPONENT_SPRITE = 1 << 3
+};
+
+/// Entity
+///	 A handle to an entity in an EntityStore.  The generation tells a live entity apart from a destroyed one
+///  whose slot has been reused, so a handle that outlives its entity is detected rather than aliasing another.
+struct Entity
+{
+	uint32_t index;
+	uint32_t generation;
+};
+
+/// EntityStore
+///	 Stores entities as a structure of arrays: every component field is its own densely packed array, indexed
+///  by the entity's position in the store (0 to getCount() - 1), so systems run over contiguous memory with no
+///  virtual calls or pointer chasing.  Destroying an entity moves the last entity into its place; handles stay
+///  valid as they go through a slot table.  Array pointers are invalidated by create and destroy.
+class EntityStore
+{
+public:
+	/// Initializes a new instance of EntityStore.
+	EntityStore(void)
+	{
+		freeSlot = NO_SLOT;
+	}
+
+	/// Reserves room for a number of entities, so creating them does not reallocate the arrays.
+	///  @count The number of entities.
+	void reserve(size_t count)
+	{
+		owners.reserve(count);
+		masks.reserve(count);
+		x.reserve(count);
+		y.reserve(count);
+		previousX.reserve(count);
+		previousY.reserve(count);
+		velocityX.reserve(count);
+		velocityY.reserve(count);
+		width.reserve(count);
+		height.reserve(count);
+		frame.reserve(count);
+		firstFrame.reserve(count);
+		lastFrame.reserve(count);
+		frameTime.reserve(count);
+	}
+
+	/// Creates an entity with zeroed components.
+	///  @components The COMPONENT bits of the entity.
+	///  @returns The handle of the entity.
+	Entity create(uint32_t components)
+	{
+		uint32_t slot = freeSlot;
+		if(slot != NO_SLOT)
+		{
+			freeSlot = slots[slot];
+		}
+		else
+		{
+			slot = slots.size();
+			slots.push_back(0);
+			generations.push_back(0);
+		}
+
+		slots[slot] = owners.size();
+		owners.push_back(slot);
+		masks.push_back(components);
+		x.push_back(0);
+		y.push_back(0);
+		previousX.push_back(0);
+		previousY.push_back(0);
+		velocityX.push_back(0);
+		velocityY.push_back(0);
+		width.push_back(0);
+		height.push_back(0);
+		frame.push_back(0);
+		firstFrame.push_back(0);
+		lastFrame.push_back(0);
+		frameTime.push_back(0);
+
+		Entity entity = { slot, generations[slot] };
+		return entity;
+	}
+
+	/// Destroys an entity.  Destroying an entity that is no longer alive does nothing.
+	///  @entity The handle of the entity.
+	void destroy(Entity entity)
+	{
+		int index = getIndex(entity);
+		if(index < 0)
+		{
+			return;
+		}
+
+		// the last entity takes the place of the destroyed one
+		size_t last = owners.size() - 1;
+		if((size_t)index != last)
+		{
+			moveEntity(last, index);
+			slots[owners[index]] = index;
+		}
+		popEntity();
+
+		generations[entity.index]++;
+		slots[entity.index] = freeSlot;
+		freeSlot = entity.index;
+	}
+
+	/// Destroys every entity.  Existing handles are no longer alive.
+	void clear(void)
+	{
+		while(!owners.empty())
+		{
+			Entity entity = getEntity(owners.size() - 1);
+			destroy(entity);
+		}
+	}
+
+	/// Returns true if a handle refers to a live entity.
+	///  @entity The handle of the entity.
+	///  @returns True if the entity has not been destroyed; false otherwise.
+	bool isAlive(Entity entity)
+	{
+		return getIndex(entity) >= 0;
+	}
+
+	/// Gets the position of an entity in the component arrays.  The position changes when other entities are destroyed.
+	///  @entity The handle of the entity.
+	///  @returns The index into the component arrays, or -1 if the entity is not alive.
+	int getIndex(Entity entity)
+	{
+		if(entity.index >= slots.size() || generations[entity.index] != entity.generation)
+		{
+			return -1;
+		}
+		return slots[entity.index];
+	}
+
+	/// Gets the handle of the entity at a position in the component arrays.
+	///  @index The index into the component arrays.
+	///  @returns The handle of the entity.
+	Entity getEntity(int index)
+	{
+		Entity entity = { owners[index], generations[owners[index]] };
+		return entity;
+	}
+
+	/// Gets the number of live entities, the length of every component array.
+	///  @returns The entity count.
+	int getCount(void)
+	{
+		return owners.size();
+	}
+
+	/// Gets the COMPONENT bits of every entity.
+	uint32_t* getMasks(void) { return masks.data(); }
+
+	/// Gets the horizontal positions.
+	float* getX(void) { return x.data(); }
+
+	/// Gets the vertical positions.
+	float* getY(void) { return y.data(); }
+
+	/// Gets the horizontal positions before the last update.
+	float* getPreviousX(void) { return previousX.data(); }
+
+	/// Gets the vertical positions before the last update.
+	float* getPreviousY(void) { return previousY.data(); }
+
+	/// Gets the horizontal velocities.
+	float* getVelocityX(void) { return velocityX.data(); }
+
+	/// Gets the vertical velocities.
+	float* getVelocityY(void) { return velocityY.data(); }
+
+	/// Gets the box widths.
+	float* getWidth(void) { return width.data(); }
+
+	/// Gets the box heights.
+	float* getHeight(void) { return height.data(); }
+
+	/// Gets the sprite index currently drawn.
+	int* getFrame(void) { return frame.data(); }
+
+	/// Gets the first sprite index of each animation.
+	int* getFirstFrame(void) { return firstFrame.data(); }
+
+	/// Gets the last sprite index of each animation.  An entity whose last frame is not past its first is not animated.
+	int* getLastFrame(void) { return lastFrame.data(); }
+
+	/// Gets the time spent on the current frame of each animation.
+	float* getFrameTime(void) { return frameTime.data(); }
+
+	/// Sets the position of an entity, with no motion to interpolate from.
+	///  @index The index into the component arrays.
+	///  @posX The horizontal position.
+	///  @posY The vertical position.
+	void setPosition(int index, float posX, float posY)
+	{
+		x[index] = previousX[index] = posX;
+		y[index] = previousY[index] = posY;
+	}
+
+	/// Sets the sprite of an entity.
+	///  @index The index into the component arrays.
+	///  @first The first sprite index of the animation.
+	///  @last The last sprite index of the animation, the same as 'first' for a still sprite.
+	void setSprite(int index, int first, int last)
+	{
+		frame[index] = firstFrame[index] = first;
+		lastFrame[index] = last;
+		frameTime[index] = 0;
+	}
+
+private:
+	/// Marks the end of the free slot list.
+	static const uint32_t NO_SLOT = 0xFFFFFFFF;
+
+	/// Copies every component of an entity to another position in the arrays.
+	void moveEntity(size_t from, size_t to)
+	{
+		owners[to] = owners[from];
+		masks[to] = masks[from];
+		x[to] = x[from];
+		y[to] = y[from];
+		previousX[to] = previousX[from];
+		previousY[to] = previousY[from];
+		velocityX[to] = velocityX[from];
+		velocityY[to] = velocityY[from];
+		width[to] = width[from];
+		height[to] = height[from];
+		frame[to] = frame[from];
+		firstFrame[to] = firstFrame[from];
+		lastFrame[to] = lastFrame[from];
+		frameTime[to] = frameTime[from];
+	}
+
+	/// Removes the last entity from every array.
+	void popEntity(void)
+	{
+		owners.pop_back();
+		masks.pop_back();
+		x.pop_back();
+		y.pop_back();
+		previousX.pop_back();
+		previousY.pop_back();
+		velocityX.pop_back();
+		velocityY.pop_back();
+		width.pop_back();
+		height.pop_back();
+		frame.pop_back();
+		firstFrame.pop_back();
+		lastFrame.pop_back();
+		frameTime.pop_back();
+	}
+
+	// The slot table: the array index of a live entity, or the next free slot; and the generation of each slot
+	std::vector<uint32_t> slots;
+	std::vector<uint32_t> generations;
+	uint32_t freeSlot;
+
+	// The slot owning each array index, and the component arrays
+	std::vector<uint32_t> owners;
+	std::vector<uint32_t> masks;
+	std::vector<float> x;
+	std::vector<float> y;
+	std::vector<float> previousX;
+	std::vector<float> previousY;
+	std::vector<float> velocityX;
+	std::vector<float> velocityY;
+	std::vector<float> width;
+	std::vector<float> height;
+	std::vector<int> frame;
+	std::vector<int> firstFrame;
+	std::vector<int> lastFrame;
+	std::vector<float> frameTime;
+};
+
+/// EntitySystems
+///	 Systems that run over every entity of a store with the components they need.
+namespace EntitySystems
+{
+	/// Moves entities by their velocity, keeping the previous position for interpolation.
+	///  @store The entities.
+	///  @elapsed The elapsed time of the update.
+	inline void integrate(EntityStore& store, float elapsed)
+	{
+		int count = store.getCount();
+		const uint32_t* masks = store.getMasks();
+		float* x = store.getX();
+		float* y = store.getY();
+		float* previousX = store.getPreviousX();
+		float* previousY = store.getPreviousY();
+		const float* velocityX = store.getVelocityX();
+		const float* velocityY = store.getVelocityY();
+
+		const uint32_t needed = COMPONENT_POSITION | COMPONENT_VELOCITY;
+		for(int i = 0; i < count; i++)
+		{
+			if((masks[i] & needed) != needed)
+			{
+				continue;
+			}
+			previousX[i] = x[i];
+			previousY[i] = y[i];
+			x[i] += velocityX[i] * elapsed;
+			y[i] += velocityY[i] * elapsed;
+		}
+	}
+
+	/// Advances the frame of animated sprites, looping back to the first frame after the last.
+	///  @store The entities.
+	///  @elapsed The elapsed time of the update.
+	///  @delay The time each frame is shown for.
+	inline void animate(EntityStore& store, float elapsed, float delay)
+	{
+		int count = store.getCount();
+		const uint32_t* masks = store.getMasks();
+		int* frame = store.getFrame();
+		const int* firstFrame = store.getFirstFrame();
+		const int* lastFrame = store.getLastFrame();
+		float* frameTime = store.getFrameTime();
+
+		for(int i = 0; i < count; i++)
+		{
+			if(!(masks[i] & COMPONENT_SPRITE) || lastFrame[i] <= firstFrame[i])
+			{
+				continue;
+			}
+
+			frameTime[i] += elapsed;
+			while(frameTime[i] >= delay)
+			{
+				frameTime[i] -= delay;
+				frame[i] = frame[i] < lastFrame[i] ? frame[i] + 1 : firstFrame[i];
+			}
+		}
+	}
+
+	/// Records the sprites of entities at their positions, interpolated between the last two updates.  Entities
+	/// with bounds that lie off screen are skipped.
+	///  @store The entities.
+	///  @xinfo The graphics information for game.
+	///  @commands The buffer the sprites are recorded into.
+	///  @layer The layer the sprites are drawn on.
+	///  @sheet The spritesheet the frames index.
+	///  @mask The clip mask of the spritesheet, or None.
+	///  @alpha How far the clock has moved past the last update, from 0 to 1.
+	///  @offsetX The horizontal screen position of the world origin.
+	///  @offsetY The vertical screen position of the world origin.
+	inline void draw(EntityStore& store, XInfo* xinfo, CommandBuffer* commands, int layer, Spritesheet* sheet, Pixmap mask,
+		float alpha, int offsetX, int offsetY)
+	{
+		int count = store.getCount();
+		const uint32_t* masks = store.getMasks();
+		const float* x = store.getX();
+		const float* y = store.getY();
+		const float* previousX = store.getPreviousX();
+		const float* previousY = store.getPreviousY();
+		const float* width = store.getWidth();
+		const float* height = store.getHeight();
+		const int* frame = store.getFrame();
+		int screenWidth = xinfo->getImageWidth();
+		int screenHeight = xinfo->getImageHeight();
+
+		const uint32_t needed = COMPONENT_POSITION | COMPONENT_SPRITE;
+		for(int i = 0; i < count; i++)
+		{
+			if((masks[i] & needed) != needed)
+			{
+				continue;
+			}
+			int posx = MATH::ifloor(MATH::lerp(previousX[i], x[i], alpha)) + offsetX;
+			int posy = MATH::ifloor(MATH::lerp(previousY[i], y[i], alpha)) + offsetY;
+			if((masks[i] & COMPONENT_BOUNDS) &&
+				(posx + width[i] <= 0 || posy + height[i] <= 0 || posx >= screenWidth || posy >= screenHeight))
+			{
+				continue;
+			}
+			commands->drawSprite(layer, sheet, mask, posx, posy, frame[i]);
+		}
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+/// Contains number formatting that writes into caller-provided buffers without locales or allocation.
+namespace Format
+{
+	/// Writes the decimal digits of an unsigned integer, in the manner of std::to_chars.  No terminator is written.
+	///  @first The start of the buffer.
+	///  @last One past the end of the buffer.
+	///  @value The value to format.
+	///  @returns One past the last character written, or NULL if the buffer is too small.
+	static char* toChars(char* first, char* last, unsigned long value)
+	{
+		// the digits are produced from the least significant, so they are written backwards and then moved
+		char digits[20];
+		int count = 0;
+		do
+		{
+			digits[count++] = (char)('0' + value % 10);
+			value /= 10;
+		}
+		while(value != 0);
+
+		if(last - first < count)
+		{
+			return NULL;
+		}
+
+		while(count > 0)
+		{
+			*first++ = digits[--count];
+		}
+		return first;
+	}
+}
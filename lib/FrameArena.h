@@ -0,0 +1,221 @@
+#pragma once
+
+/// Standard libraries
+#include <cstdlib>
+#include <cstddef>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+/// Project components
+#include "Logger.h"
+
+namespace Constants
+{
+	/// The size (in bytes) of each block of the per-frame arena.
+	static const size_t FRAME_ARENA_SIZE = 64 * 1024;
+}
+
+namespace Logger
+{
+	/// Frame Arena Messages
+	static const char* INFO_ARENA_HIGHWATER = "# Frame arena high water (bytes) = ";
+	static const char* INFO_ARENA_BLOCKS = "# Frame arena blocks = ";
+}
+
+/// FrameArena
+///	 A linear allocator for objects that live no longer than a frame.  Allocation bumps an offset and nothing
+///  is freed individually; the whole arena is rewound when the frame ends.  When a block fills up another is
+///  chained on, and blocks are kept across frames so the arena stops touching the heap once it has warmed up.
+///  Destructors are never run, so only trivially destructible objects or arena-backed containers belong here.
+class FrameArena
+{
+public:
+	/// Initializes a new instance of FrameArena.
+	///  @size The size (in bytes) of each block.
+	FrameArena(size_t size = Constants::FRAME_ARENA_SIZE)
+	{
+		blockSize = size;
+		current = 0;
+		offset = 0;
+		highWater = 0;
+
+		addBlock(blockSize);
+	}
+
+	/// Disposes of the FrameArena instance.
+	~FrameArena(void)
+	{
+		for(size_t i = 0; i < blocks.size(); i++)
+		{
+			free(blocks[i].memory);
+		}
+	}
+
+	/// Allocates memory that remains valid until the arena is reset.
+	///  @size The number of bytes to allocate.
+	///  @alignment The alignment of the memory, a power of two.
+	///  @returns The allocated memory.
+	void* allocate(size_t size, size_t alignment = alignof(std::max_align_t))
+	{
+		size_t start = alignOffset(current, offset, alignment);
+		while(start + size > blocks[current].size)
+		{
+			current++;
+			if(current == blocks.size())
+			{
+				addBlock(std::max(blockSize, size + alignment));
+			}
+			start = alignOffset(current, 0, alignment);
+		}
+
+		offset = start + size;
+		return blocks[current].memory + start;
+	}
+
+	/// Allocates an uninitialized array that remains valid until the arena is reset.
+	///  @count The number of elements.
+	///  @returns The allocated array.
+	template<class T>
+	T* allocateArray(size_t count)
+	{
+		return (T*)allocate(sizeof(T) * count, alignof(T));
+	}
+
+	/// Rewinds the arena, invalidating everything allocated since the last reset.
+	void reset(void)
+	{
+		highWater = std::max(highWater, getUsed());
+		current = 0;
+		offset = 0;
+	}
+
+	/// Gets the number of bytes handed out since the last reset, including alignment and block tails.
+	///  @returns The bytes in use.
+	size_t getUsed(void)
+	{
+		size_t used = offset;
+		for(size_t i = 0; i < current; i++)
+		{
+			used += blocks[i].size;
+		}
+		return used;
+	}
+
+	/// Gets the most bytes used by any frame.
+	///  @returns The high water mark in bytes.
+	size_t getHighWater(void)
+	{
+		return std::max(highWater, getUsed());
+	}
+
+	/// Gets the number of blocks the arena has allocated.
+	///  @returns The block count.
+	size_t getBlockCount(void)
+	{
+		return blocks.size();
+	}
+
+private:
+	/// A contiguous region of the arena.
+	struct Block
+	{
+		char* memory;
+		size_t size;
+	};
+
+	/// Adds a block to the end of the chain.
+	void addBlock(size_t size)
+	{
+		Block block;
+		block.memory = (char*)malloc(size);
+		block.size = size;
+		if(block.memory == NULL)
+		{
+			Logger::application_error("Can't allocate the frame arena.");
+		}
+		blocks.push_back(block);
+	}
+
+	/// Rounds an offset within a block up so the address it refers to is aligned.
+	size_t alignOffset(size_t index, size_t position, size_t alignment)
+	{
+		uintptr_t address = (uintptr_t)(blocks[index].memory + position);
+		uintptr_t aligned = (address + alignment - 1) & ~(uintptr_t)(alignment - 1);
+		return position + (aligned - address);
+	}
+
+	std::vector<Block> blocks;
+	size_t blockSize;
+	size_t current;
+	size_t offset;
+	size_t highWater;
+};
+
+/// ArenaAllocator
+///	 An STL allocator that places container storage in a FrameArena.  Deallocation does nothing; the storage
+///  is reclaimed when the arena is reset, so containers using it must not outlive the frame.
+template<class T>
+class ArenaAllocator
+{
+public:
+	typedef T value_type;
+
+	/// Initializes a new instance of ArenaAllocator.
+	///  @owner The arena to allocate from.
+	ArenaAllocator(FrameArena& owner) :
+		arena(&owner)
+	{
+	}
+
+	/// Initializes a new instance of ArenaAllocator from an allocator of another type.
+	///  @other The allocator whose arena is shared.
+	template<class U>
+	ArenaAllocator(const ArenaAllocator<U>& other) :
+		arena(other.getArena())
+	{
+	}
+
+	/// Allocates storage for a number of elements.
+	///  @count The number of elements.
+	///  @returns The allocated storage.
+	T* allocate(size_t count)
+	{
+		return arena->allocateArray<T>(count);
+	}
+
+	/// Storage is reclaimed when the arena is reset.
+	void deallocate(T* memory, size_t count)
+	{
+	}
+
+	/// Gets the arena the allocator draws from.
+	///  @returns The arena.
+	FrameArena* getArena(void) const
+	{
+		return arena;
+	}
+
+private:
+	FrameArena* arena;
+};
+
+template<class T, class U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+{
+	return a.getArena() == b.getArena();
+}
+
+template<class T, class U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+{
+	return a.getArena() != b.getArena();
+}
+
+/// A string whose characters live in a FrameArena.
+typedef std::basic_string<char, std::char_traits<char>, ArenaAllocator<char> > ArenaString;
+
+/// A vector whose elements live in a FrameArena.
+template<class T>
+using ArenaVector = std::vector<T, ArenaAllocator<T> >;
@@ -3,13 +3,17 @@
 /// Standard libraries
 #include <iostream>
 #include <list>
+#include <vector>
 #include <cstdlib>
-#include <sys/time.h>
 #include <math.h>
 #include <stdio.h>
 #include <string>
 #include <cstring>
 #include <iostream>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <atomic>
 
 /// X11 libraries
 #include <X11/Xlib.h>
@@ -22,11 +26,29 @@
 #include "XInfo.h"
 #include "Displayable.h"
 #include "GameTime.h"
+#include "Profiler.h"
+#include "FrameArena.h"
+#include "Camera.h"
+#include "CommandBuffer.h"
+#include "JobSystem.h"
+#include "TripleBuffer.h"
 #include "Logger.h"
 #include "Constants.h"
 
 using namespace std;
 
+/// FrameSnapshot
+///	 The game-wide part of a published snapshot: the camera and the time the simulation had reached.
+struct FrameSnapshot
+{
+	GameTime time;
+	Camera camera;
+
+	/// The time the clock had moved past the last simulation step, and the time it was published (XInfo::getNow)
+	unsigned long remainder;
+	unsigned long published;
+};
+
 /// Game
 ///	 Game is the base class for an object that can be updated/drawn to the screen.  It includes
 ///  additional functionality such as initialize/load/unload for a self contained component.
@@ -55,24 +77,28 @@ public:
 	///  @xinfo The graphics information for game.
 	virtual void initialize(XInfo* xinfo) = 0;
 
+	/// Copies the state draw reads into a snapshot slot, like Displayable::publish.
+	///  @slot The slot to fill, from 0 to Constants::TRIPLE_BUFFER_SLOTS - 1.
+	virtual void publish(int slot)
+	{
+	}
+
 	/// Handles system level input operations for the game.
 	///  @xinfo The graphics information for game.
 	///  @gameTime Time elapsed since the last call to draw.
 	virtual void handleSystemInput(XInfo* xinfo, GameTime* gameTime) = 0;
 
 	/// Call this method to initialize the game, begin running the game loop, and start processing events for the game.
+	///  The simulation is advanced in fixed steps of 1/tickRate seconds, while frames are drawn at fps with an
+	///  interpolation alpha describing how far the clock has moved past the last simulation step.  After the steps
+	///  of each frame, the state the components draw is published as a snapshot (see Displayable::publish).  With
+	///  Constants::USE_RENDER_THREAD, frames are drawn from the latest snapshot on a render thread of their own, so
+	///  a stalled X server does not hold up input or the simulation; otherwise the snapshot is drawn straight away.
 	///  @xinfo The graphics information for game.	
 	void run(XInfo* xinfo)
 	{
-		XEvent event;
-
-		int inside = 0;
 		gameRunning = true;
 
-		unsigned long gameStart = GameTime::getNow();
-		unsigned long prevTime = GameTime::getNow();
-		Display* dply = xinfo->getDisplay();
-
 		Logger::application_debug(Logger::LOG_GAMEINIT);
 		game_initialize(xinfo);
 		Logger::application_debug(Logger::LOG_TASKDONE);
@@ -84,65 +110,43 @@ public:
 
 		xinfo->openw();
 
-		Logger::application_debug(Logger::LOG_GAMESTART);
-		while(gameRunning)
-		{
-			GameTime* gameTime = new GameTime(prevTime, gameStart);
-			// handle all the events currently in the queue
-
-			// Although this could possibly block (unending event list) it is
-			// unlikely and more of a stress case than a real world scenario
-			// At least for the purposes of this assignment
-			while(XPending(dply) > 0)
-			{
-				XNextEvent(dply, &event);
-				switch(event.type)
-				{
-				case KeyRelease:
-					handleKeyRelease(xinfo, &event);
-					break;
-				case KeyPress:
-					handleKeyPress(xinfo, &event);
-					break;
-				case MotionNotify:
-					handleMotion(xinfo, &event, inside);
-					break;
-				case EnterNotify:
-					inside = 1;
-					break;
-				case LeaveNotify:
-					inside = 0;
-					break;
-				case ConfigureNotify:
-					handleResize(xinfo, &event);
-					break;
-				}
-			}
-
-			// sleep	
-			xinfo->wait(FPS_COEFFICIENT / fps);
-
-			game_update(xinfo, gameTime);
-			game_draw(xinfo, gameTime);
-
-			// flush buffer to display
-			xinfo->flush();
+		tickStep = Constants::NANOS_PER_SECOND / tickRate;
+		frameStep = Constants::NANOS_PER_SECOND / fps;
+		GameTime gameTime;
 
-			// record previous time for game time object
-			prevTime = gameTime->getCurrentTime();
+		// the loaded state is published so the first frame has something to draw
+		game_publish(xinfo, &gameTime, 0);
 
-			handleSystemInput(xinfo, gameTime);
+		Logger::application_debug(Logger::LOG_GAMESTART);
+		if(Constants::USE_RENDER_THREAD && xinfo->openEventConnection())
+		{
+			rendering = true;
+			std::thread renderer(&Game::runRenderer, this, xinfo);
+			runSimulation(xinfo, &gameTime);
 
-			free(gameTime);
+			rendering = false;
+			renderer.join();
+		}
+		else
+		{
+			runFrames(xinfo, &gameTime);
 		}
 		Logger::application_debug(Logger::LOG_GAMEEND);
+		Logger::application_info(Logger::INFO_ARENA_HIGHWATER, frameArena.getHighWater());
+		Logger::application_info(Logger::INFO_ARENA_BLOCKS, frameArena.getBlockCount());
+		commands.report();
+
+		if(Constants::PROFILE_OUTPUT != NULL)
+		{
+			profiler.write(Constants::PROFILE_OUTPUT);
+		}
 
 		// unloads assets from each component
 		Logger::application_debug(Logger::LOG_ASSETRELEASING);
 		game_unload(xinfo);
 		Logger::application_debug(Logger::LOG_ASSETRELEASED);
 
-		XCloseDisplay(xinfo->getDisplay());
+		xinfo->close();
 	}
 
 	/// Setting properties in the game.
@@ -177,48 +181,317 @@ public:
 		fps = value;
 	}
 
+	/// Returns the number of simulation updates per second of the game.
+	///  @returns The tick rate of the game.
+	int getTickRate(void)
+	{
+		return tickRate;
+	}
+
+	/// Sets the number of simulation updates per second of the game.
+	///  @value The value to set.
+	void setTickRate(int value)
+	{
+		tickRate = value;
+	}
+
 	/// Adds a Displayable component to the game.
 	///  @displayable The component to add to the game.
 	void addComponent(Displayable* displayable)
 	{
 		// when a component is added, it is then called in the game_ methods.
 		components.push_front(displayable);
+		displayable->setFrameArena(&frameArena);
+		displayable->setCamera(&camera);
+		displayable->setView(&view, &snapshots);
+		displayable->setCommandBuffer(&commands);
+	}
+
+protected:
+	/// Gets the arena for objects that only live until the end of the frame.
+	///  @returns The frame arena of the game.
+	FrameArena* getFrameArena(void)
+	{
+		return &frameArena;
+	}
+
+	/// Gets the camera the components follow while updating.
+	///  @returns The camera of the game.
+	Camera* getCamera(void)
+	{
+		return &camera;
+	}
+
+	/// Gets the buffer the sprites of a frame are recorded to.
+	///  @returns The command buffer of the game.
+	CommandBuffer* getCommandBuffer(void)
+	{
+		return &commands;
+	}
+
+	/// Gets the snapshot slot draw reads from.
+	///  @returns The slot last filled by publish that is being drawn.
+	int getDrawSlot(void)
+	{
+		return snapshots.getFront();
+	}
+
+	/// Gets the lock the render thread holds while it draws a frame.  The game thread takes it around anything
+	/// that loads or releases resources the components draw with, such as changing level.
+	///  @returns The render lock.
+	std::mutex& getRenderLock(void)
+	{
+		return renderLock;
 	}
 
 private:
-	static const unsigned long FPS_COEFFICIENT = 1000000;
+	/// Runs the game loop on the game thread alone: each frame advances the simulation, then draws.
+	void runFrames(XInfo* xinfo, GameTime* gameTime)
+	{
+		unsigned long accumulator = 0;
+		unsigned long prevTime = xinfo->getNow();
+
+		while(gameRunning)
+		{
+			unsigned long frameStart = xinfo->getNow();
+			unsigned long frameClock = GameTime::getNow();
+
+			game_step(xinfo, gameTime, &accumulator, &prevTime);
+			game_render(xinfo, frameClock);
+
+			// sleep for the remainder of the frame
+			unsigned long frameCost = xinfo->getNow() - frameStart;
+			if(frameCost < frameStep)
+			{
+				xinfo->wait((frameStep - frameCost) / Constants::NANOS_PER_MICRO);
+			}
+		}
+	}
+
+	/// Runs the simulation on the game thread while the render thread draws: each pass advances the simulation
+	/// and publishes it, then sleeps until the next step is due.
+	void runSimulation(XInfo* xinfo, GameTime* gameTime)
+	{
+		unsigned long accumulator = 0;
+		unsigned long prevTime = xinfo->getNow();
+
+		while(gameRunning)
+		{
+			game_step(xinfo, gameTime, &accumulator, &prevTime);
+
+			if(accumulator < tickStep)
+			{
+				xinfo->wait((tickStep - accumulator) / Constants::NANOS_PER_MICRO);
+			}
+		}
+	}
+
+	/// Draws the latest snapshot at fps on the render thread until the simulation ends.
+	void runRenderer(XInfo* xinfo)
+	{
+		while(rendering)
+		{
+			unsigned long frameStart = xinfo->getNow();
+			{
+				std::lock_guard<std::mutex> lock(renderLock);
+				xinfo->handleRenderEvents();
+				game_render(xinfo, GameTime::getNow());
+			}
+
+			// sleep for the remainder of the frame
+			unsigned long frameCost = xinfo->getNow() - frameStart;
+			if(frameCost < frameStep)
+			{
+				xinfo->wait((frameStep - frameCost) / Constants::NANOS_PER_MICRO);
+			}
+		}
+	}
+
+	/// Handles events and advances the simulation by the time since the last call, in fixed steps, then
+	/// publishes the state reached.
+	///  @accumulator The time not yet simulated, carried between calls.
+	///  @prevTime The time of the last call.
+	void game_step(XInfo* xinfo, GameTime* gameTime, unsigned long* accumulator, unsigned long* prevTime)
+	{
+		unsigned long now = xinfo->getNow();
+		unsigned long frameTime = now - *prevTime;
+		*prevTime = now;
+
+		// drop time beyond a long stall rather than spiralling to catch up
+		if(frameTime > Constants::MAX_FRAME_TIME)
+		{
+			frameTime = Constants::MAX_FRAME_TIME;
+		}
+		*accumulator += frameTime;
+
+		// handle all the events currently in the queue
+		{
+			ProfileScope scope(profiler, eventSection);
+			xinfo->handleEvents();
+		}
+		handleProfilerInput(xinfo);
+
+		// advance the simulation in fixed steps
+		while(gameRunning && *accumulator >= tickStep)
+		{
+			gameTime->tick(tickStep);
+			game_update(xinfo, gameTime);
+
+			handleSystemInput(xinfo, gameTime);
+			*accumulator -= tickStep;
+		}
+
+		game_publish(xinfo, gameTime, *accumulator);
+	}
+
+	/// Publishes the state the game and its components draw, with the camera and the time it was reached at.
+	///  @remainder The time the clock had moved past the last simulation step when published.
+	void game_publish(XInfo* xinfo, GameTime* gameTime, unsigned long remainder)
+	{
+		ProfileScope scope(profiler, publishSection);
+
+		int slot = snapshots.getBack();
+		FrameSnapshot& frame = frames[slot];
+		frame.time = *gameTime;
+		frame.camera = camera;
+		frame.remainder = remainder;
+		frame.published = xinfo->getNow();
+
+		publish(slot);
+
+		list<Displayable*>::const_iterator begin = components.begin();
+		list<Displayable*>::const_iterator end = components.end();
+
+		while(begin != end)
+		{
+			Displayable *d = *begin;
+			d->publish(slot);
+			begin++;
+		}
+
+		snapshots.publish();
+	}
+
+	/// Draws and presents the latest snapshot, interpolated to the current time.
+	///  @frameClock The time the frame started, for the profiler.
+	void game_render(XInfo* xinfo, unsigned long frameClock)
+	{
+		snapshots.acquire();
+		FrameSnapshot& frame = frames[snapshots.getFront()];
+
+		// the alpha counts the time since the snapshot was published, so a late frame still shows the present
+		unsigned long since = xinfo->getNow() - frame.published;
+		GameTime gameTime = frame.time;
+		gameTime.setAlpha(std::min(1.0f, (float)(frame.remainder + since) / tickStep));
+
+		view = frame.camera;
+		view.interpolate(gameTime.getAlpha());
+
+		game_draw(xinfo, &gameTime);
+
+		if(profiler.isVisible())
+		{
+			profiler.draw(xinfo);
+		}
+
+		// flush buffer to display
+		{
+			ProfileScope scope(profiler, flushSection);
+			xinfo->flush();
+		}
+		profiler.add(frameSection, GameTime::getNow() - frameClock);
+
+		// everything allocated for this frame is released at once
+		frameArena.reset();
+	}
 
 	/// Draws the Game component to the screen.
 	void game_draw(XInfo* xinfo, GameTime* gameTime)
 	{
 		xinfo->clear();
 
-		draw(xinfo, gameTime);
+		{
+			ProfileScope scope(profiler, drawSection);
+			draw(xinfo, gameTime);
+		}
 
 		list<Displayable *>::const_iterator begin = components.begin();
 		list<Displayable *>::const_iterator end = components.end();
+		vector<int>::const_iterator section = drawSections.begin();
 
 		while( begin != end )
 		{
+			ProfileScope scope(profiler, *section);
 			Displayable *d = *begin;
 			d->draw(xinfo, gameTime);
 			begin++;
+			section++;
+		}
+
+		// the sprites recorded by every component are drawn together, sorted by layer and state
+		{
+			ProfileScope scope(profiler, submitSection);
+			commands.submit(xinfo);
 		}
 	}
 
 	/// Updates the Game component based on recent changes.
+	///  Components are updated in waves of consecutive components that do not conflict (see
+	///  Displayable::conflictsWith); the components of a wave are updated at the same time on the job system.
+	///  Components that conflict are still updated in the order they were added, so the result is the same
+	///  however many threads there are.
 	void game_update(XInfo* xinfo, GameTime* gameTime)
 	{
-		update(xinfo, gameTime);
+		{
+			ProfileScope scope(profiler, updateSection);
+			update(xinfo, gameTime);
+		}
 
-		list<Displayable*>::const_iterator begin = components.begin();
-		list<Displayable*>::const_iterator end = components.end();
+		for(size_t wave = 0; wave < updateWaves.size(); wave++)
+		{
+			const vector<int>& members = updateWaves[wave];
 
-		while(begin != end)
+			JobCounter counter;
+			for(size_t i = 1; i < members.size(); i++)
+			{
+				int index = members[i];
+				jobs.run(counter, [this, index, xinfo, gameTime]() { updateComponent(index, xinfo, gameTime); });
+			}
+			updateComponent(members[0], xinfo, gameTime);
+			jobs.wait(counter);
+		}
+	}
+
+	/// Updates a single component, timing it in its profiler section.
+	void updateComponent(int index, XInfo* xinfo, GameTime* gameTime)
+	{
+		ProfileScope scope(profiler, updateSections[index]);
+		updateOrder[index]->update(xinfo, gameTime);
+	}
+
+	/// Groups the components into update waves, in the order they were added.
+	void initializeUpdateWaves(void)
+	{
+		updateOrder.assign(components.begin(), components.end());
+		updateWaves.clear();
+
+		for(size_t i = 0; i < updateOrder.size(); i++)
 		{
-			Displayable *d = *begin;		
-			d->update(xinfo, gameTime);
-			begin++;
+			bool conflicts = updateWaves.empty();
+			if(!conflicts)
+			{
+				const vector<int>& wave = updateWaves.back();
+				for(size_t j = 0; j < wave.size() && !conflicts; j++)
+				{
+					conflicts = updateOrder[i]->conflictsWith(updateOrder[wave[j]]);
+				}
+			}
+
+			if(conflicts)
+			{
+				updateWaves.push_back(vector<int>());
+			}
+			updateWaves.back().push_back(i);
 		}
 	}
 
@@ -258,6 +531,9 @@ private:
 	void game_initialize(XInfo* xinfo)
 	{
 		setFps(Constants::DEFAULT_FPS);
+		setTickRate(Constants::DEFAULT_TICK_RATE);
+		jobs.setThreadCount(Constants::JOB_THREADS);
+		camera.setViewport(xinfo->getImageWidth(), xinfo->getImageHeight());
 
 		initialize(xinfo); 
 
@@ -270,49 +546,86 @@ private:
 			d->initialize(xinfo);
 			begin++;
 		}
-	}
 
-	/// Handles motion events based on mouse input device.
-	void handleMotion(XInfo* xinfo, XEvent* event, int inside)
-	{
-		if(inside)
-		{
-			xinfo->getMouseState()->setX(event->xmotion.x);
-			xinfo->getMouseState()->setY(event->xmotion.y);
-		}
+		initializeProfiler();
+		initializeUpdateWaves();
 	}
 
-	/// Handles the window resize event.
-	void handleResize(XInfo* xinfo, XEvent* event)
+	/// Adds the profiler sections for the event pump, each component and the flush.
+	void initializeProfiler(void)
 	{
-		XConfigureEvent xce = event->xconfigure;
-		Rectangle* pix = xinfo->getGraphicBounds();
+		eventSection = profiler.addSection("events");
+		updateSection = profiler.addSection("update:Game");
+		drawSection = profiler.addSection("draw:Game");
 
-		if (xce.width > pix->getWidth()|| xce.height > pix->getHeight())
-		{		
-			int xDiff = xce.width - pix->getWidth();
-			int yDiff = xce.height - pix->getHeight();
+		list<Displayable*>::const_iterator begin = components.begin();
+		list<Displayable*>::const_iterator end = components.end();
 
-			pix->setPoint(xDiff / 2, yDiff / 2);
+		while(begin != end)
+		{
+			Displayable *d = *begin;
+			updateSections.push_back(profiler.addSection(string("update:") + d->getName()));
+			drawSections.push_back(profiler.addSection(string("draw:") + d->getName()));
+			begin++;
 		}
-	}
 
-	/// Handles a keyboard key press event.
-	void handleKeyPress(XInfo* xinfo, XEvent* event)
-	{
-		XKeyEvent* kEvent = (XKeyEvent*)event;
-		xinfo->getKeyboardState()->set((KEYS)kEvent->keycode);
+		publishSection = profiler.addSection("publish");
+		submitSection = profiler.addSection("submit");
+		flushSection = profiler.addSection("flush");
+		frameSection = profiler.addSection("frame");
 	}
 
-	/// Handles a keyboard key release event.
-	void handleKeyRelease(XInfo* xinfo, XEvent* event)
+	/// Toggles the profiler overlay when the profiler key is pressed.
+	void handleProfilerInput(XInfo* xinfo)
 	{
-		XKeyEvent* kEvent = (XKeyEvent*)event;
-		xinfo->getKeyboardState()->clear((KEYS)kEvent->keycode);
+		if(xinfo->getKeyboardState()->isKeyDown(KEY_P))
+		{
+			profiler.toggle();
+
+			//clear the key so it requires another press to toggle again
+			xinfo->getKeyboardState()->clear(KEY_P);
+		}
 	}
 
 	std::list<Displayable*> components;
+
+	/// Arena for transient objects, reset at the end of every frame
+	FrameArena frameArena;
+
+	/// Threads the component updates are spread across, and the components in update order grouped into waves
+	JobSystem jobs;
+	std::vector<Displayable*> updateOrder;
+	std::vector<std::vector<int> > updateWaves;
+
+	/// The view onto the world, followed during update, and the copy of it drawn through, interpolated each frame
+	Camera camera;
+	Camera view;
+
+	/// The snapshots drawn from, their slots, and the lock held while a frame is drawn
+	TripleBuffer snapshots;
+	FrameSnapshot frames[Constants::TRIPLE_BUFFER_SLOTS];
+	std::mutex renderLock;
+	std::atomic<bool> rendering;
+
+	/// Sprite draws recorded by the components, submitted at the end of each frame
+	CommandBuffer commands;
+
+	/// Frame profiler and the sections of each component, in component order
+	Profiler profiler;
+	std::vector<int> updateSections;
+	std::vector<int> drawSections;
+	int eventSection;
+	int updateSection;
+	int drawSection;
+	int publishSection;
+	int submitSection;
+	int flushSection;
+	int frameSection;
+
 	int fps;
+	int tickRate;
+	unsigned long tickStep;
+	unsigned long frameStep;
 	int border;
 	int buffersize;
 	char* windowTitle;
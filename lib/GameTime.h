@@ -2,14 +2,14 @@
 
 /// Standard libraries
 #include <stdio.h>
-#include <sys/time.h>
+#include <time.h>
 
 /// Project components
 #include "Constants.h"
 
 /// GameTime
 ///	 The GameTime class is designed to store information about time relating to the frames drawn.  It provides
-///	 details such as time elapsed since last update or the current frame time.
+///	 details such as time elapsed since last update or the current frame time.  All times are in nanoseconds.
 class GameTime
 {
 public:
@@ -22,18 +22,18 @@ public:
 
 		_totalGametime = 0;
 		_elapsed = 0;
+		_alpha = 0.0f;
 	}
 
-	/// Creates a new instance of GameTime.
-	///  @previousTime The elapsed game time since the last update.
-	///  @totalGameTime The amount of game time since the start of the game. 
-	GameTime(unsigned long previousTime, unsigned long totalGameTime)
+	/// Advances the game time by a fixed simulation step.
+	///  @step The length of the step in nanoseconds.
+	void tick(unsigned long step)
 	{
-		_now = getNow();
-		_prev = previousTime;
+		_prev = _now;
+		_now = _now + step;
 
-		_elapsed = (_now - _prev);
-		_totalGametime = totalGameTime;
+		_elapsed = step;
+		_totalGametime += step;
 	}
 
 	/// Gets the current clock time.
@@ -50,36 +50,52 @@ public:
 		return _elapsed;
 	}
 
-	/// The clock time at the start of the game.
+	/// The amount of game time simulated since the start of the game.
 	///  @returns The total game time.
 	unsigned long getTotalTime(void)
 	{
 		return _totalGametime;
 	}
 
-	/// Gets the timestamp associated with the previous frame.
-	///  @returns The previous frame clock time.
+	/// Gets the timestamp associated with the previous update.
+	///  @returns The previous update clock time.
 	unsigned long getPreviousTime(void)
 	{
 		return _prev;
 	}
 
-	/// Gets the elapsed time as a computed millisecond format.
+	/// Gets the elapsed time as a computed delta (tenths of a second).
 	///  @returns The elapsed delta component.
 	float getElapsedDelta(void)
 	{
 		return (float)_elapsed / Constants::TIME_DIVISOR;
 	}
 
-	/// Get the current time in microseconds.
-	///  @returns The time value in microseconds.
+	/// Gets the fraction of a simulation step that has passed since the last update, in the range [0, 1].  It is 1
+	///  when drawing has fallen a whole step behind, so a late frame shows the current state.
+	///  Draw calls use this to interpolate between the previous and current simulation states.
+	///  @returns The interpolation alpha.
+	float getAlpha(void)
+	{
+		return _alpha;
+	}
+
+	/// Sets the fraction of a simulation step that has passed since the last update.
+	///  @alpha The interpolation alpha.
+	void setAlpha(float alpha)
+	{
+		_alpha = alpha;
+	}
+
+	/// Get the current monotonic time in nanoseconds.
+	///  @returns The time value in nanoseconds.
 	static unsigned long getNow()
 	{
-		timeval tv;
-		gettimeofday(&tv, 0);
+		timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
 
-		// Gets the current seconds * 1000 + microseconds / 1000
-		unsigned long time = tv.tv_sec * 1000 + tv.tv_usec / 1000;
+		// Gets the current seconds * 10^9 + nanoseconds
+		unsigned long time = (unsigned long)ts.tv_sec * Constants::NANOS_PER_SECOND + ts.tv_nsec;
 		return time;
 	}
 
@@ -88,4 +104,5 @@ private:
 	unsigned long _prev;
 	unsigned long _elapsed;
 	unsigned long _totalGametime;
+	float _alpha;
 };
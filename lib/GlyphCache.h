@@ -0,0 +1,156 @@
+#pragma once
+
+/// Standard libraries
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+
+/// X11/XLib libraries
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/extensions/Xrender.h>
+
+namespace Constants
+{
+	/// The first and last characters rasterized into a glyph cache (those the font has).
+	static const int GLYPH_FIRST = 0;
+	static const int GLYPH_LAST = 255;
+}
+
+/// GlyphCache
+///	 The single-byte characters of a core font rasterized once into an XRender glyph set on the server, so a string
+///  is drawn with a composite request naming its characters instead of core text requests.  Glyph ids are the
+///  character codes, and each glyph advances by the width the font gives it, as XTextWidth measures it.
+class GlyphCache
+{
+public:
+	/// Initializes a new instance of GlyphCache.  No glyphs are cached until create is called.
+	GlyphCache(void)
+	{
+		glyphs = None;
+	}
+
+	/// Rasterizes the single-byte characters of a font and adds them to a new glyph set.  The characters are drawn
+	/// side by side into a bitmap and read back with one request, then sent as 8-bit alpha glyphs.
+	///  @display The display the glyph set is created on.
+	///  @drawable A drawable on the screen of the glyph set.
+	///  @font The font to rasterize.
+	///  @format The 8-bit alpha picture format of the glyphs.
+	///  @returns True if the glyph set was created, false otherwise.
+	bool create(Display* display, Drawable drawable, XFontStruct* font, XRenderPictFormat* format)
+	{
+		int first = std::max(Constants::GLYPH_FIRST, (int)font->min_char_or_byte2);
+		int last = std::min(Constants::GLYPH_LAST, (int)font->max_char_or_byte2);
+		if(first > last)
+		{
+			return false;
+		}
+
+		int height = font->ascent + font->descent;
+		int stripWidth = 0;
+		for(int c = first; c <= last; c++)
+		{
+			XCharStruct* metrics = getMetrics(font, c);
+			stripWidth += std::max(0, metrics->rbearing - metrics->lbearing);
+		}
+		if(stripWidth == 0 || height <= 0)
+		{
+			return false;
+		}
+
+		Pixmap strip = XCreatePixmap(display, drawable, stripWidth, height, 1);
+		GC gc = XCreateGC(display, strip, 0, NULL);
+		XSetForeground(display, gc, 0);
+		XFillRectangle(display, strip, gc, 0, 0, stripWidth, height);
+		XSetForeground(display, gc, 1);
+		XSetFont(display, gc, font->fid);
+
+		int left = 0;
+		for(int c = first; c <= last; c++)
+		{
+			XCharStruct* metrics = getMetrics(font, c);
+			char character = (char)c;
+			XDrawString(display, strip, gc, left - metrics->lbearing, font->ascent, &character, 1);
+			left += std::max(0, metrics->rbearing - metrics->lbearing);
+		}
+
+		XImage* bits = XGetImage(display, strip, 0, 0, stripWidth, height, 1, XYPixmap);
+		XFreeGC(display, gc);
+		XFreePixmap(display, strip);
+		if(bits == NULL)
+		{
+			return false;
+		}
+
+		// 8-bit glyph rows are padded to four bytes
+		std::vector<Glyph> ids;
+		std::vector<XGlyphInfo> infos;
+		std::vector<char> data;
+
+		left = 0;
+		for(int c = first; c <= last; c++)
+		{
+			XCharStruct* metrics = getMetrics(font, c);
+			int width = std::max(0, metrics->rbearing - metrics->lbearing);
+			int stride = (width + 3) & ~3;
+
+			XGlyphInfo info;
+			info.width = width;
+			info.height = width > 0 ? height : 0;
+			info.x = -metrics->lbearing;
+			info.y = font->ascent;
+			info.xOff = metrics->width;
+			info.yOff = 0;
+
+			size_t offset = data.size();
+			data.resize(offset + (size_t)stride * info.height, 0);
+			for(int y = 0; y < info.height; y++)
+			{
+				for(int x = 0; x < width; x++)
+				{
+					data[offset + y * stride + x] = XGetPixel(bits, left + x, y) ? (char)0xFF : 0;
+				}
+			}
+
+			ids.push_back(c);
+			infos.push_back(info);
+			left += width;
+		}
+		XDestroyImage(bits);
+
+		glyphs = XRenderCreateGlyphSet(display, format);
+		XRenderAddGlyphs(display, glyphs, &ids[0], &infos[0], ids.size(), &data[0], data.size());
+		return true;
+	}
+
+	/// Releases the glyph set.
+	///  @display The display the glyph set was created on.
+	void release(Display* display)
+	{
+		if(glyphs != None)
+		{
+			XRenderFreeGlyphSet(display, glyphs);
+			glyphs = None;
+		}
+	}
+
+	/// Gets the glyph set of the cached characters.
+	///  @returns The glyph set, or None if none was created.
+	GlyphSet getGlyphSet(void)
+	{
+		return glyphs;
+	}
+
+private:
+	/// Gets the metrics of a character, or the font's largest when it has no per-character metrics.
+	static XCharStruct* getMetrics(XFontStruct* font, int c)
+	{
+		if(font->per_char == NULL)
+		{
+			return &font->max_bounds;
+		}
+		return &font->per_char[c - font->min_char_or_byte2];
+	}
+
+	GlyphSet glyphs;
+};
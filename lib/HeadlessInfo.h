@@ -0,0 +1,471 @@
+#pragma once
+
+/// Standard libraries
+#include <cstdlib>
+#include <cstring>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+/// X11 libraries
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+
+/// Project components
+#include "XInfo.h"
+#include "GameTime.h"
+#include "KeyboardState.h"
+#include "MouseState.h"
+#include "Rectangle.h"
+#include "Logger.h"
+#include "Keys.h"
+
+namespace Constants
+{
+	/// The command line flag that selects the headless platform.
+	static const char* HEADLESS_FLAG = "--headless";
+
+	/// The default number of frames a headless session runs before quitting.
+	static const long HEADLESS_DEFAULT_FRAMES = 1000;
+}
+
+namespace Logger
+{
+	/// Headless Session Messages
+	static const char* INFO_HEADLESS_FRAMES = "# Headless frames = ";
+	static const char* INFO_HEADLESS_MILLIS = "# Headless elapsed milliseconds = ";
+	static const char* INFO_HEADLESS_FPS = "# Headless frames per second = ";
+	static const char* INFO_HEADLESS_DRAWS = "# Headless draw calls = ";
+	static const char* LOG_SCRIPTERROR = "# Unable to read input script: ";
+}
+
+/// ScriptedKey
+///	 A single keyboard transition applied by the headless platform at a given frame.
+struct ScriptedKey
+{
+	/// The frame the transition is applied on.
+	long frame;
+
+	/// The key that changes state.
+	KEYS key;
+
+	/// True if the key is pressed, false if released.
+	bool down;
+};
+
+/// HeadlessInfo
+///	 A display-less platform that accepts the same draw calls as XInfo without an X server.  Keyboard
+///  state is fed from an input script and the game is quit after a fixed number of frames.
+class HeadlessInfo :
+	public XInfo
+{
+public:
+	/// HeadlessInfo constructor.
+	HeadlessInfo(void)
+	{
+		frameLimit = Constants::HEADLESS_DEFAULT_FRAMES;
+		frame = 0;
+		drawCalls = 0;
+		nextKey = 0;
+		startTime = 0;
+		clock = 0;
+		pixmapCount = 0;
+	}
+
+	/// Returns true if the arguments request the headless platform.
+	///  @argc The number of arguments.
+	///  @argv The arguments list.
+	///  @returns True if headless was requested, false otherwise.
+	static bool isRequested(int argc, char* argv[])
+	{
+		for(int i = 1; i < argc; i++)
+		{
+			if(strcmp(argv[i], Constants::HEADLESS_FLAG) == 0)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/// Overloaded. Initializes the platform state without opening a display.
+	///  @argc The number of arguments.
+	///  @argv The arguments list.
+	virtual void initialize(int argc, char* argv[])
+	{
+		display = NULL;
+		window = None;
+		screen = 0;
+		depth = 24;
+		font = NULL;
+		pixmap = target = None;
+		gdraw = gcontext[0] = NULL;
+		gtext = gcontext[1] = NULL;
+
+		hints.x = 0;
+		hints.y = 0;
+		hints.width = Constants::DEFAULT_WINDOW_WIDTH;
+		hints.height = Constants::DEFAULT_WINDOW_HEIGHT;
+		hints.flags = PPosition | PSize;
+
+		pix_bounds = new Rectangle(0, 0, hints.width, hints.height);
+		backdrop = None;
+		damage.setBounds(hints.width, hints.height);
+		lastDamage.setBounds(hints.width, hints.height);
+		present.setBounds(hints.width, hints.height);
+
+		mouse = new MouseState();
+		keyboard = new KeyboardState();
+
+		for(int i = 1; i < argc; i++)
+		{
+			std::string cmdparam(argv[i]);
+			if(cmdparam.find("--frames=") == 0)
+			{
+				frameLimit = atol(cmdparam.substr(9).c_str());
+			}
+			else if(cmdparam.find("--script=") == 0)
+			{
+				loadScript(cmdparam.substr(9).c_str());
+			}
+		}
+
+		// the compositor runs entirely in client memory, so its blending can be measured without a display
+		initializeCompositor();
+		initializeAssetPack(true);
+	}
+
+	/// Overloaded. Creates a client-side image without a display connection.
+	///  @data The pixel data, owned by the image after creation.
+	///  @width The width of the image.
+	///  @height The height of the image.
+	///  @returns The created image.
+	virtual XImage* createImage(char* data, int width, int height)
+	{
+		if(data == NULL)
+		{
+			data = (char*)calloc((size_t)width * height, 4);
+		}
+
+		XImage* img = (XImage*)calloc(1, sizeof(XImage));
+		img->width = width;
+		img->height = height;
+		img->xoffset = 0;
+		img->format = ZPixmap;
+		img->data = data;
+		img->byte_order = LSBFirst;
+		img->bitmap_unit = 32;
+		img->bitmap_bit_order = LSBFirst;
+		img->bitmap_pad = 32;
+		img->depth = depth;
+		img->bytes_per_line = width * 4;
+		img->bits_per_pixel = 32;
+		img->red_mask = 0xFF0000L;
+		img->green_mask = 0x00FF00L;
+		img->blue_mask = 0x0000FFL;
+		XInitImage(img);
+
+		return img;
+	}
+
+	/// Overloaded. Clip masks are not required without a display.
+	virtual Pixmap readPixmap(const char* filename)
+	{
+		return None;
+	}
+
+	/// Overloaded. Clip masks are not required without a display.
+	virtual Pixmap createBitmap(const char* bits, int width, int height)
+	{
+		return None;
+	}
+
+	/// Overloaded. Images stay in client memory without a display.
+	virtual void upload(XImage* img)
+	{
+	}
+
+	/// Overloaded. Records an image draw, blending it when compositing.
+	virtual void draw(int x, int y, int posx, int posy, int width, int height, XImage* img, Pixmap mask)
+	{
+		drawCalls++;
+		if(compositing)
+		{
+			XInfo::draw(x, y, posx, posy, width, height, img, mask);
+		}
+	}
+
+	/// Overloaded. Records a spritesheet draw, blending it when compositing.
+	virtual void draw(Spritesheet* sheet, int x, int y, int index)
+	{
+		drawCalls++;
+		if(compositing)
+		{
+			XInfo::draw(sheet, x, y, index);
+		}
+	}
+
+	/// Overloaded. Records a texture atlas draw, blending it when compositing.
+	virtual void draw(TextureAtlas* atlas, int x, int y, int id)
+	{
+		drawCalls++;
+		if(compositing)
+		{
+			XInfo::draw(atlas, x, y, id);
+		}
+	}
+
+	/// Overloaded. Records a string draw.
+	virtual void drawString(const char* text, int x, int y, unsigned long colour)
+	{
+		drawCalls++;
+	}
+
+	using XInfo::drawString;
+
+	/// Overloaded. Records a rectangle outline draw.
+	virtual void drawRectangle(GC gc, int x, int y, unsigned int width, unsigned int height)
+	{
+		drawCalls++;
+	}
+
+	/// Overloaded. Records a rectangle fill.
+	virtual void fillRectangle(GC gc, int x, int y, unsigned int width, unsigned int height)
+	{
+		drawCalls++;
+	}
+
+	/// Overloaded. Graphic context state is not tracked.
+	virtual void setColor(GC gc, const unsigned long value)
+	{
+	}
+
+	/// Overloaded. Graphic context state is not tracked.
+	virtual void setMask(Pixmap img_mask)
+	{
+	}
+
+	/// Overloaded. Graphic context state is not tracked.
+	virtual void clearMask(void)
+	{
+	}
+
+	/// Overloaded. Restores the framebuffer when compositing, otherwise there is no back buffer to clear.
+	virtual void clear(void)
+	{
+		if(compositing)
+		{
+			XInfo::clear();
+		}
+	}
+
+	/// Overloaded. There is no window to present to.
+	virtual void flush(void)
+	{
+		lastDamage.clear();
+	}
+
+	/// Overloaded. Starts timing the headless session.
+	virtual void openw(void)
+	{
+		startTime = GameTime::getNow();
+	}
+
+	/// Overloaded. Reports throughput of the headless session.
+	virtual void close(void)
+	{
+		unsigned long elapsed = (GameTime::getNow() - startTime) / Constants::NANOS_PER_MILLI;
+
+		Logger::application_info(Logger::INFO_HEADLESS_FRAMES, frame);
+		Logger::application_info(Logger::INFO_HEADLESS_MILLIS, elapsed);
+		Logger::application_info(Logger::INFO_HEADLESS_FPS, elapsed > 0 ? (frame * 1000) / elapsed : frame * 1000);
+		Logger::application_info(Logger::INFO_HEADLESS_DRAWS, drawCalls);
+
+		releaseCompositor();
+	}
+
+	/// Overloaded. There is no display to read input from, so frames are drawn on the game thread and a session
+	/// stays repeatable.
+	///  @returns False.
+	virtual bool openEventConnection(void)
+	{
+		return false;
+	}
+
+	/// Overloaded. Applies the scripted input for the current frame, quitting once the frame limit is reached.
+	virtual void handleEvents(void)
+	{
+		while(nextKey < script.size() && script[nextKey].frame <= frame)
+		{
+			ScriptedKey& entry = script[nextKey];
+			if(entry.down)
+			{
+				keyboard->set(entry.key);
+			}
+			else
+			{
+				keyboard->clear(entry.key);
+			}
+			nextKey++;
+		}
+
+		if(frameLimit > 0 && frame + 1 >= frameLimit)
+		{
+			keyboard->set(KEY_Q);
+		}
+
+		frame++;
+	}
+
+	/// Overloaded. Releases a compositor surface, otherwise there is no pixmap to release.
+	virtual void freePixmap(Pixmap pxm)
+	{
+		releaseSurface(pxm);
+	}
+
+	/// Overloaded. Returns a compositor surface when compositing, otherwise a placeholder pixmap identifier.
+	virtual Pixmap createPixmap(int width, int height)
+	{
+		if(compositing)
+		{
+			return createSurface(width, height);
+		}
+		return ++pixmapCount;
+	}
+
+	/// Overloaded. Returns a placeholder layer identifier, or None when compositing, as the compositor has no layers.
+	virtual Pixmap createLayer(int width, int height)
+	{
+		if(compositing)
+		{
+			return None;
+		}
+		return ++pixmapCount;
+	}
+
+	/// Overloaded. There is no mask to clear.
+	virtual void clearLayer(Pixmap layer, int x, int y, int width, int height)
+	{
+	}
+
+	/// Overloaded. Records a layer scroll.
+	virtual void scrollLayer(Pixmap layer, int dx, int dy)
+	{
+		drawCalls++;
+	}
+
+	/// Overloaded. Records a layer copy.
+	virtual void drawLayer(Pixmap layer, int x, int y)
+	{
+		drawCalls++;
+	}
+
+	/// Overloaded. Records a pixmap copy, copying the surface when compositing.
+	virtual void copyArea(Pixmap src, int srcx, int srcy, int width, int height, int x, int y)
+	{
+		drawCalls++;
+		if(compositing)
+		{
+			XInfo::copyArea(src, srcx, srcy, width, height, x, y);
+		}
+	}
+
+	/// Overloaded. Frames are not throttled without a display; the virtual clock is advanced instead.
+	///  @time The number of microseconds to advance the clock.
+	virtual void wait(long time)
+	{
+		clock += time * Constants::NANOS_PER_MICRO;
+	}
+
+	/// Overloaded. Gets the virtual clock, which only moves when the game waits.
+	///  @returns The virtual time in nanoseconds.
+	virtual unsigned long getNow(void)
+	{
+		return clock;
+	}
+
+	/// Overloaded. There is no display to create a graphic context from.
+	virtual GC createGraphicContext(void)
+	{
+		return NULL;
+	}
+
+	/// Returns the number of frames processed.
+	///  @returns The processed frame count.
+	long getFrameCount(void)
+	{
+		return frame;
+	}
+
+	/// Returns the number of draw calls received.
+	///  @returns The draw call count.
+	long getDrawCount(void)
+	{
+		return drawCalls;
+	}
+
+private:
+	/// Loads a keyboard script.  Each line holds a frame number, a key name and 'down' or 'up'.
+	///  @filename The path of the input script.
+	void loadScript(const char* filename)
+	{
+		FILE* filePtr = fopen(filename, "r");
+		if(filePtr == NULL)
+		{
+			Logger::application_debug(Logger::LOG_SCRIPTERROR, filename);
+			return;
+		}
+
+		long keyFrame;
+		char name[16];
+		char action[8];
+		while(fscanf(filePtr, "%ld %15s %7s", &keyFrame, name, action) == 3)
+		{
+			ScriptedKey entry;
+			entry.frame = keyFrame;
+			entry.down = strcmp(action, "down") == 0;
+
+			if(!getKey(name, &entry.key))
+			{
+				continue;
+			}
+			script.push_back(entry);
+		}
+		fclose(filePtr);
+
+		std::stable_sort(script.begin(), script.end(), compareFrame);
+	}
+
+	/// Resolves a key name to its key value.
+	///  @name The name of the key.
+	///  @key The resolved key.
+	///  @returns True if the name is known, false otherwise.
+	static bool getKey(const char* name, KEYS* key)
+	{
+		if(strcmp(name, "SPACE") == 0) { *key = KEY_SPACE; return true; }
+		if(strcmp(name, "LEFT") == 0) { *key = KEY_LEFT; return true; }
+		if(strcmp(name, "RIGHT") == 0) { *key = KEY_RIGHT; return true; }
+		if(strcmp(name, "Q") == 0) { *key = KEY_Q; return true; }
+		if(strcmp(name, "J") == 0) { *key = KEY_J; return true; }
+		if(strcmp(name, "E") == 0) { *key = KEY_E; return true; }
+		if(strcmp(name, "P") == 0) { *key = KEY_P; return true; }
+		return false;
+	}
+
+	/// Orders scripted keys by frame.
+	static bool compareFrame(const ScriptedKey& a, const ScriptedKey& b)
+	{
+		return a.frame < b.frame;
+	}
+
+	std::vector<ScriptedKey> script;
+	size_t nextKey;
+
+	long frame;
+	long frameLimit;
+	long drawCalls;
+	unsigned long startTime;
+	unsigned long clock;
+	Pixmap pixmapCount;
+};
@@ -0,0 +1,203 @@
+#pragma once
+
+/// Standard libraries
+#include <cstring>
+
+/// X11 libraries
+#include <X11/Xlib.h>
+
+/// Project components
+#include "XInfo.h"
+#include "CommandBuffer.h"
+
+namespace Constants
+{
+	/// The number of strings and rectangles a HUD layer holds.
+	static const int HUD_ITEMS = 8;
+
+	/// The length of the text buffer of a HUD string, including the terminator.
+	static const int HUD_TEXT_LENGTH = 64;
+}
+
+/// HudItem
+///	 A string or filled rectangle of a HUD layer, positioned relative to the layer.
+struct HudItem
+{
+	enum Type { NONE, STRING, RECTANGLE };
+
+	Type type;
+	char text[Constants::HUD_TEXT_LENGTH];
+	int x;
+	int y;
+	unsigned int width;
+	unsigned int height;
+	unsigned long colour;
+};
+
+/// HudLayer
+///	 Strings and rectangles drawn over the frame from an off-screen layer (see XInfo::createLayer).  The layer is
+///  only rendered again when an item changes; otherwise each frame costs one masked copy.  Without layers (as
+///  with the software compositor) the items are drawn directly every frame.
+class HudLayer
+{
+public:
+	/// Initializes a new instance of HudLayer with no items.
+	HudLayer(void)
+	{
+		layer = None;
+		count = 0;
+		dirty = true;
+		renders = 0;
+	}
+
+	/// Creates the off-screen layer.
+	///  @xinfo The graphics information for game.
+	///  @width The width of the layer.
+	///  @height The height of the layer.
+	void load(XInfo* xinfo, int width, int height)
+	{
+		layer = xinfo->createLayer(width, height);
+		dirty = true;
+	}
+
+	/// Releases the off-screen layer.
+	///  @xinfo The graphics information for game.
+	void unload(XInfo* xinfo)
+	{
+		if(layer != None)
+		{
+			xinfo->freePixmap(layer);
+			layer = None;
+		}
+	}
+
+	/// Sets an item to an outlined string, marking the layer for rendering if it changed.
+	///  @item The index of the item.
+	///  @text The string; longer strings are cut to the text buffer.
+	///  @x The x-coordinate (in layer coordinates) of the string.
+	///  @y The y-coordinate (in layer coordinates) of the baseline.
+	///  @colour The color of the string.
+	void setString(int item, const char* text, int x, int y, unsigned long colour)
+	{
+		HudItem& entry = getItem(item);
+		if(entry.type == HudItem::STRING && entry.x == x && entry.y == y && entry.colour == colour &&
+			strncmp(entry.text, text, Constants::HUD_TEXT_LENGTH - 1) == 0)
+		{
+			return;
+		}
+
+		entry.type = HudItem::STRING;
+		strncpy(entry.text, text, Constants::HUD_TEXT_LENGTH - 1);
+		entry.text[Constants::HUD_TEXT_LENGTH - 1] = '\0';
+		entry.x = x;
+		entry.y = y;
+		entry.width = 0;
+		entry.height = 0;
+		entry.colour = colour;
+		dirty = true;
+	}
+
+	/// Sets an item to a filled rectangle, marking the layer for rendering if it changed.
+	///  @item The index of the item.
+	///  @x The x-coordinate (in layer coordinates) of the rectangle.
+	///  @y The y-coordinate (in layer coordinates) of the rectangle.
+	///  @rectWidth The width of the rectangle.
+	///  @rectHeight The height of the rectangle.
+	///  @colour The color of the rectangle.
+	void setRectangle(int item, int x, int y, unsigned int rectWidth, unsigned int rectHeight, unsigned long colour)
+	{
+		HudItem& entry = getItem(item);
+		if(entry.type == HudItem::RECTANGLE && entry.x == x && entry.y == y &&
+			entry.width == rectWidth && entry.height == rectHeight && entry.colour == colour)
+		{
+			return;
+		}
+
+		entry.type = HudItem::RECTANGLE;
+		entry.text[0] = '\0';
+		entry.x = x;
+		entry.y = y;
+		entry.width = rectWidth;
+		entry.height = rectHeight;
+		entry.colour = colour;
+		dirty = true;
+	}
+
+	/// Draws the items at a position, rendering the layer first if an item changed.  The layer is recorded to the
+	/// command buffer, so it is drawn in order with the sprites.
+	///  @xinfo The graphics information for game.
+	///  @commands The command buffer the layer is recorded to.
+	///  @drawLayer The layer of the command buffer to draw on.
+	///  @x The x-coordinate (in screen coordinates) of the layer.
+	///  @y The y-coordinate (in screen coordinates) of the layer.
+	void draw(XInfo* xinfo, CommandBuffer* commands, int drawLayer, int x, int y)
+	{
+		if(layer == None)
+		{
+			drawItems(xinfo, x, y);
+			return;
+		}
+
+		if(dirty)
+		{
+			xinfo->setRenderTarget(layer);
+			xinfo->clearLayer(layer);
+			drawItems(xinfo, 0, 0);
+			xinfo->resetRenderTarget();
+
+			dirty = false;
+			renders++;
+		}
+		commands->drawLayer(drawLayer, layer, x, y);
+	}
+
+	/// Gets the number of times the layer was rendered.
+	///  @returns The render count.
+	long getRenderCount(void)
+	{
+		return renders;
+	}
+
+private:
+	/// Gets an item, adding empty items up to it.
+	HudItem& getItem(int item)
+	{
+		while(count <= item)
+		{
+			items[count].type = HudItem::NONE;
+			count++;
+		}
+		return items[item];
+	}
+
+	/// Draws the items, offset by a position.
+	void drawItems(XInfo* xinfo, int x, int y)
+	{
+		GC gc = xinfo->getGraphicContext();
+		for(int i = 0; i < count; i++)
+		{
+			HudItem& entry = items[i];
+			switch(entry.type)
+			{
+			case HudItem::STRING:
+				xinfo->drawString(entry.text, x + entry.x, y + entry.y, entry.colour);
+				break;
+			case HudItem::RECTANGLE:
+				xinfo->setColor(gc, entry.colour);
+				xinfo->fillRectangle(gc, x + entry.x, y + entry.y, entry.width, entry.height);
+				break;
+			case HudItem::NONE:
+				break;
+			}
+		}
+	}
+
+	Pixmap layer;
+
+	HudItem items[Constants::HUD_ITEMS];
+	int count;
+
+	/// Set when an item changed since the layer was rendered
+	bool dirty;
+	long renders;
+};
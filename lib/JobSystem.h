@@ -0,0 +1,295 @@
+#pragma once
+
+/// Standard libraries
+#include <cstdlib>
+#include <vector>
+#include <deque>
+#include <functional>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+
+namespace Constants
+{
+	/// The number of worker threads of the job system.  A negative value uses one less than the number of
+	/// hardware threads; zero runs every job on the thread that submits it.
+	static int JOB_THREADS = -1;
+}
+
+/// JobCounter
+///	 Counts the jobs of a fork/join that have not finished.  JobSystem::wait returns once it reaches zero.
+class JobCounter
+{
+public:
+	/// Initializes a new instance of JobCounter.
+	JobCounter(void) :
+		pending(0)
+	{
+	}
+
+	/// Returns true if every job counted has finished.
+	///  @returns True if no jobs are pending; false otherwise.
+	bool isDone(void)
+	{
+		return pending.load(std::memory_order_acquire) == 0;
+	}
+
+private:
+	friend class JobSystem;
+	std::atomic<int> pending;
+};
+
+/// JobSystem
+///	 A work-stealing thread pool.  Each thread owns a queue: it takes its own newest job first, and an idle
+///  thread steals the oldest job from another.  Jobs are forked with run and joined with wait; the waiting
+///  thread runs queued jobs rather than blocking, so jobs can fork and join jobs of their own.  Jobs may run in
+///  any order and on any thread, so jobs forked together must not touch the same data.  Only one thread
+///  outside the pool (normally the game thread) may submit jobs.  The workers are started by the first job.
+class JobSystem
+{
+public:
+	/// Initializes a new instance of JobSystem.
+	JobSystem(void) :
+		queued(0)
+	{
+		threadCount = 0;
+		started = false;
+		stopping = false;
+	}
+
+	/// Disposes of the JobSystem instance, stopping the workers.  Every job must have been joined.
+	~JobSystem(void)
+	{
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+			stopping = true;
+		}
+		wake.notify_all();
+
+		for(size_t i = 0; i < workers.size(); i++)
+		{
+			workers[i].join();
+		}
+		for(size_t i = 0; i < queues.size(); i++)
+		{
+			delete queues[i];
+		}
+	}
+
+	/// Sets the number of worker threads.  Has no effect once the workers have started.
+	///  @count The number of workers; a negative value uses one less than the number of hardware threads.
+	void setThreadCount(int count)
+	{
+		if(started)
+		{
+			return;
+		}
+		if(count < 0)
+		{
+			count = std::max(0, (int)std::thread::hardware_concurrency() - 1);
+		}
+		threadCount = count;
+	}
+
+	/// Gets the number of worker threads.
+	///  @returns The number of workers, not counting the thread submitting jobs.
+	int getThreadCount(void)
+	{
+		return threadCount;
+	}
+
+	/// Forks a job.  Without workers the job runs immediately.
+	///  @counter The counter the job is joined with.
+	///  @work The job.
+	void run(JobCounter& counter, const std::function<void()>& work)
+	{
+		if(threadCount == 0)
+		{
+			work();
+			return;
+		}
+		start();
+
+		counter.pending.fetch_add(1, std::memory_order_relaxed);
+
+		Job job;
+		job.work = work;
+		job.counter = &counter;
+
+		// counted before it is queued, so the count never drops below zero when a job is taken at once
+		queued.fetch_add(1);
+		Queue* queue = queues[getQueueIndex()];
+		{
+			std::lock_guard<std::mutex> lock(queue->mutex);
+			queue->jobs.push_back(job);
+		}
+
+		// taking the lock orders the count against a worker that is about to sleep
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+		}
+		wake.notify_one();
+	}
+
+	/// Joins the jobs of a counter, running queued jobs until they have all finished.
+	///  @counter The counter the jobs were forked with.
+	void wait(JobCounter& counter)
+	{
+		while(!counter.isDone())
+		{
+			Job job;
+			if(take(getQueueIndex(), &job))
+			{
+				execute(job);
+			}
+			else
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	/// Calls a function over a range split into fixed-size pieces, in parallel, and waits for every piece.
+	/// The pieces depend only on the range and grain, not on the number of threads.
+	///  @begin The first index of the range.
+	///  @end One past the last index of the range.
+	///  @grain The largest number of indices given to one call.
+	///  @body The function, called with the first index and one past the last index of each piece.
+	void parallelFor(int begin, int end, int grain, const std::function<void(int, int)>& body)
+	{
+		grain = std::max(1, grain);
+
+		JobCounter counter;
+		for(int first = begin; first < end; first += grain)
+		{
+			int last = std::min(end, first + grain);
+			run(counter, [&body, first, last]() { body(first, last); });
+		}
+		wait(counter);
+	}
+
+private:
+	/// A forked job and the counter it is joined with.
+	struct Job
+	{
+		std::function<void()> work;
+		JobCounter* counter;
+	};
+
+	/// The jobs owned by one thread.
+	struct Queue
+	{
+		std::mutex mutex;
+		std::deque<Job> jobs;
+	};
+
+	/// Gets the queue of the current thread: a worker's own queue, or queue 0 for the submitting thread.
+	static int& getQueueIndex(void)
+	{
+		static thread_local int index = 0;
+		return index;
+	}
+
+	/// Creates the queues and workers, once.
+	void start(void)
+	{
+		if(started)
+		{
+			return;
+		}
+		started = true;
+
+		for(int i = 0; i <= threadCount; i++)
+		{
+			queues.push_back(new Queue());
+		}
+		for(int i = 1; i <= threadCount; i++)
+		{
+			workers.push_back(std::thread(&JobSystem::runWorker, this, i));
+		}
+	}
+
+	/// Takes the newest job of a thread's own queue, or steals the oldest job of another queue.
+	bool take(int index, Job* job)
+	{
+		if(queued.load() == 0)
+		{
+			return false;
+		}
+
+		{
+			Queue* queue = queues[index];
+			std::lock_guard<std::mutex> lock(queue->mutex);
+			if(!queue->jobs.empty())
+			{
+				*job = queue->jobs.back();
+				queue->jobs.pop_back();
+				queued.fetch_sub(1);
+				return true;
+			}
+		}
+
+		int count = queues.size();
+		for(int i = 1; i < count; i++)
+		{
+			Queue* victim = queues[(index + i) % count];
+			std::lock_guard<std::mutex> lock(victim->mutex);
+			if(!victim->jobs.empty())
+			{
+				*job = victim->jobs.front();
+				victim->jobs.pop_front();
+				queued.fetch_sub(1);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/// Runs a job and counts it as finished.
+	static void execute(Job& job)
+	{
+		job.work();
+		job.counter->pending.fetch_sub(1, std::memory_order_release);
+	}
+
+	/// The worker loop: runs jobs until the system is destroyed, sleeping while there are none.
+	void runWorker(int index)
+	{
+		getQueueIndex() = index;
+
+		while(true)
+		{
+			Job job;
+			if(take(index, &job))
+			{
+				execute(job);
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(sleepMutex);
+			while(!stopping && queued.load() == 0)
+			{
+				wake.wait(lock);
+			}
+			if(stopping)
+			{
+				return;
+			}
+		}
+	}
+
+	int threadCount;
+	bool started;
+
+	// One queue per thread, the submitting thread's first, and the number of jobs across them
+	std::vector<Queue*> queues;
+	std::vector<std::thread> workers;
+	std::atomic<int> queued;
+
+	// Idle workers sleep until a job is queued or the system is destroyed
+	std::mutex sleepMutex;
+	std::condition_variable wake;
+	bool stopping;
+};
@@ -20,5 +20,8 @@ enum KEYS
 	KEY_J = 44,
 
 	/// E Key.
-	KEY_E = 26
+	KEY_E = 26,
+
+	/// P Key.
+	KEY_P = 33
 };
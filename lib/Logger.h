@@ -27,9 +27,11 @@ namespace Logger
 	/// Argument Messages
 	static const char* LOG_ARGINVALID = "# No Arguments Discovered";
 	static const char* LOG_ARGCOUNT = "# Discovered Arguments: ";
+	static const char* LOG_ARGNOTPOSITIVE = "# Ignoring a rate that is not positive: ";
 
 	/// Console Information Messages
 	static const char* INFO_FPS = "# Frames per second (FPS) = ";
+	static const char* INFO_TICK = "# Simulation updates per second = ";
 	static const char* INFO_MOVE = "# Player move speed = ";
 	static const char* INFO_JUMP = "# Player jump speed = ";
 	static const char* INFO_SUN = "# World Sun speed = ";
@@ -78,6 +80,13 @@ namespace Logger
 		exit(0);
 	}
 
+	/// A utility function for reporting application information.
+	///  @str The detail message.
+	static void application_info(const char* str)
+	{
+		std::cout << str << std::endl;
+	}
+
 	/// A utility function for reporting application information.
 	///  @str The detail message.
 	///  @value1 Argument value for message.
@@ -43,6 +43,16 @@ namespace MATH
 		return (int)value;
 	}
 
+	/// Linearly interpolates between two values.
+	///  @value1 Source value.
+	///  @value2 Source value.
+	///  @amount Value between 0 and 1 indicating the weight of value2.
+	///  @returns The interpolated value.
+	static float lerp(float value1, float value2, float amount)
+	{
+		return value1 + (value2 - value1) * amount;
+	}
+
 	/// Returns the largest integer less than or equal to the specified floating-point number.
 	///  @value A floating-point number.
 	///  @returns The largest integer less than or equal to 'value'.
@@ -63,17 +73,17 @@ namespace MATH
 	///  @rectA The Rectangle to evaluate.
 	///  @rectB The Rectangle to evaluate.
 	///  @returns A vector component represents the vertical and horizontal intersection.
-	static Vector2* getIntersectionDepth(Rectangle* rectA, Rectangle* rectB)
+	static Vector2 getIntersectionDepth(const Rectangle& rectA, const Rectangle& rectB)
 	{
 		// Calculate half sizes.
-		float halfWidthA = rectA->getWidth() / 2.0f;
-		float halfHeightA = rectA->getHeight() / 2.0f;
-		float halfWidthB = rectB->getWidth() / 2.0f;
-		float halfHeightB = rectB->getHeight() / 2.0f;
+		float halfWidthA = rectA.getWidth() / 2.0f;
+		float halfHeightA = rectA.getHeight() / 2.0f;
+		float halfWidthB = rectB.getWidth() / 2.0f;
+		float halfHeightB = rectB.getHeight() / 2.0f;
 
 		// Calculate centers.
-		Vector2 centerA(rectA->getLeft() + halfWidthA, rectA->getTop() + halfHeightA);
-		Vector2 centerB(rectB->getLeft() + halfWidthB, rectB->getTop() + halfHeightB);
+		Vector2 centerA(rectA.getLeft() + halfWidthA, rectA.getTop() + halfHeightA);
+		Vector2 centerB(rectB.getLeft() + halfWidthB, rectB.getTop() + halfHeightB);
 
 		// Calculate current and minimum-non-intersecting distances between centers.
 		float distanceX = centerA.getX() - centerB.getX();
@@ -84,13 +94,13 @@ namespace MATH
 		// If we are not intersecting at all, return (0, 0).
 		if (abs(distanceX) >= minDistanceX || abs(distanceY) >= minDistanceY)
 		{
-			return new Vector2(0, 0);
+			return Vector2(0, 0);
 		}
 
 		// Calculate and return intersection depths.
 		float depthX = distanceX > 0 ? minDistanceX - distanceX : -minDistanceX - distanceX;
 		float depthY = distanceY > 0 ? minDistanceY - distanceY : -minDistanceY - distanceY;
 
-		return new Vector2(depthX, depthY);
+		return Vector2(depthX, depthY);
 	}
 }
@@ -0,0 +1,339 @@
+#pragma once
+
+/// Standard libraries
+#include <stdio.h>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <mutex>
+#include <atomic>
+
+/// Project components
+#include "XInfo.h"
+#include "GameTime.h"
+#include "Constants.h"
+#include "Logger.h"
+
+namespace Constants
+{
+	/// The number of recent samples kept for each profiled section.
+	static const int PROFILE_SAMPLE_COUNT = 512;
+
+	/// The file the profiler writes to on exit, CSV unless the name ends in '.json'. Disabled when NULL.
+	static const char* PROFILE_OUTPUT = NULL;
+}
+
+namespace Logger
+{
+	/// Profiler Messages
+	static const char* LOG_PROFILEERROR = "# Unable to write profile: ";
+	static const char* LOG_PROFILEWRITTEN = "# Profile written: ";
+}
+
+/// ProfileStatistics
+///	 The summary of a profiled section over its recent samples, in nanoseconds.
+struct ProfileStatistics
+{
+	unsigned long p50;
+	unsigned long p95;
+	unsigned long p99;
+	unsigned long max;
+	unsigned long mean;
+	unsigned long count;
+};
+
+/// ProfileSection
+///	 A named ring buffer of recent timings for a single section of the frame.
+class ProfileSection
+{
+public:
+	/// Initializes a new instance of ProfileSection.
+	///  @sectionName The name reported for the section.
+	ProfileSection(const std::string& sectionName) :
+		name(sectionName),
+		samples(Constants::PROFILE_SAMPLE_COUNT, 0)
+	{
+		next = 0;
+		count = 0;
+		total = 0;
+		max = 0;
+	}
+
+	/// Records a timing sample.
+	///  @value The duration in nanoseconds.
+	void add(unsigned long value)
+	{
+		samples[next] = value;
+		next = (next + 1) % Constants::PROFILE_SAMPLE_COUNT;
+
+		count++;
+		total += value;
+		if(value > max)
+		{
+			max = value;
+		}
+	}
+
+	/// Computes the percentiles of the recent samples along with the lifetime maximum and mean.
+	///  @scratch A buffer used to order the samples.
+	///  @returns The section statistics.
+	ProfileStatistics getStatistics(std::vector<unsigned long>& scratch)
+	{
+		ProfileStatistics stats;
+		memset(&stats, 0, sizeof(stats));
+
+		unsigned long window = std::min(count, (unsigned long)Constants::PROFILE_SAMPLE_COUNT);
+		if(window == 0)
+		{
+			return stats;
+		}
+
+		scratch.assign(samples.begin(), samples.begin() + window);
+		std::sort(scratch.begin(), scratch.end());
+
+		stats.p50 = scratch[(window - 1) * 50 / 100];
+		stats.p95 = scratch[(window - 1) * 95 / 100];
+		stats.p99 = scratch[(window - 1) * 99 / 100];
+		stats.max = max;
+		stats.mean = total / count;
+		stats.count = count;
+
+		return stats;
+	}
+
+	/// Gets the name of the section.
+	///  @returns The section name.
+	const std::string& getName(void)
+	{
+		return name;
+	}
+
+private:
+	std::string name;
+	std::vector<unsigned long> samples;
+	int next;
+
+	unsigned long count;
+	unsigned long total;
+	unsigned long max;
+};
+
+/// Profiler
+///	 Collects per-section frame timings and reports them as an overlay or to a file.  Sections may be timed on
+///  any thread (each section by one thread at a time) while the overlay is drawn on another.
+class Profiler
+{
+public:
+	/// Initializes a new instance of Profiler.
+	Profiler(void) :
+		visible(false)
+	{
+	}
+
+	/// Disposes of the Profiler instance.
+	~Profiler(void)
+	{
+		for(size_t i = 0; i < sections.size(); i++)
+		{
+			delete sections[i];
+		}
+	}
+
+	/// Adds a named section to the profiler.
+	///  @name The name of the section.
+	///  @returns The identifier of the section.
+	int addSection(const std::string& name)
+	{
+		sections.push_back(new ProfileSection(name));
+		return sections.size() - 1;
+	}
+
+	/// Records a timing sample for a section.
+	///  @id The identifier of the section.
+	///  @value The duration in nanoseconds.
+	void add(int id, unsigned long value)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		sections[id]->add(value);
+	}
+
+	/// Returns true if the overlay is shown.
+	///  @returns True if the overlay is visible, false otherwise.
+	bool isVisible(void)
+	{
+		return visible;
+	}
+
+	/// Toggles the visibility of the overlay.
+	void toggle(void)
+	{
+		visible = !visible;
+	}
+
+	/// Draws the section statistics (in milliseconds) over the frame.
+	///  @xinfo The graphics information for game.
+	void draw(XInfo* xinfo)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		char line[128];
+		int y = OVERLAY_TOP;
+
+		xinfo->drawString("section p50 p95 p99 max", OVERLAY_LEFT, y, ColorConstants::COLOR_WHITE);
+		for(size_t i = 0; i < sections.size(); i++)
+		{
+			ProfileStatistics stats = sections[i]->getStatistics(scratch);
+			snprintf(line, sizeof(line), "%s %.2f %.2f %.2f %.2f",
+				sections[i]->getName().c_str(),
+				toMillis(stats.p50), toMillis(stats.p95), toMillis(stats.p99), toMillis(stats.max));
+
+			y += OVERLAY_LINE_HEIGHT;
+			xinfo->drawString(line, OVERLAY_LEFT, y, ColorConstants::COLOR_YELLOW);
+		}
+	}
+
+	/// Writes the section statistics (in nanoseconds) to a file, as JSON if the name ends in '.json' and CSV otherwise.
+	///  @filename The file to write.
+	///  @returns True if successful, false otherwise.
+	bool write(const char* filename)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		FILE* filePtr = fopen(filename, "w");
+		if(filePtr == NULL)
+		{
+			Logger::application_debug(Logger::LOG_PROFILEERROR, filename);
+			return false;
+		}
+
+		size_t length = strlen(filename);
+		bool json = length >= 5 && strcmp(filename + length - 5, ".json") == 0;
+
+		if(json)
+		{
+			fprintf(filePtr, "{\n  \"sections\": [");
+		}
+		else
+		{
+			fprintf(filePtr, "section,count,p50_ns,p95_ns,p99_ns,max_ns,mean_ns\n");
+		}
+
+		for(size_t i = 0; i < sections.size(); i++)
+		{
+			ProfileStatistics stats = sections[i]->getStatistics(scratch);
+			const char* name = sections[i]->getName().c_str();
+
+			if(json)
+			{
+				fprintf(filePtr, "%s\n    { \"section\": ", i == 0 ? "" : ",");
+				writeJsonString(filePtr, name);
+				fprintf(filePtr, ", \"count\": %lu, \"p50_ns\": %lu, \"p95_ns\": %lu, \"p99_ns\": %lu, \"max_ns\": %lu, \"mean_ns\": %lu }",
+					stats.count, stats.p50, stats.p95, stats.p99, stats.max, stats.mean);
+			}
+			else
+			{
+				writeCsvField(filePtr, name);
+				fprintf(filePtr, ",%lu,%lu,%lu,%lu,%lu,%lu\n",
+					stats.count, stats.p50, stats.p95, stats.p99, stats.max, stats.mean);
+			}
+		}
+
+		if(json)
+		{
+			fprintf(filePtr, "\n  ]\n}\n");
+		}
+
+		fclose(filePtr);
+		Logger::application_debug(Logger::LOG_PROFILEWRITTEN, filename);
+		return true;
+	}
+
+private:
+	static const int OVERLAY_LEFT = 10;
+	static const int OVERLAY_TOP = 30;
+	static const int OVERLAY_LINE_HEIGHT = 26;
+
+	/// Writes a quoted JSON string, escaping quotes, backslashes and control characters.
+	static void writeJsonString(FILE* filePtr, const char* text)
+	{
+		fputc('"', filePtr);
+		for(const char* c = text; *c != '\0'; c++)
+		{
+			unsigned char character = (unsigned char)*c;
+			if(character == '"' || character == '\\')
+			{
+				fputc('\\', filePtr);
+				fputc(character, filePtr);
+			}
+			else if(character < 0x20)
+			{
+				fprintf(filePtr, "\\u%04x", character);
+			}
+			else
+			{
+				fputc(character, filePtr);
+			}
+		}
+		fputc('"', filePtr);
+	}
+
+	/// Writes a CSV field, quoted (with quotes doubled) if it holds a delimiter, quote or line break.
+	static void writeCsvField(FILE* filePtr, const char* text)
+	{
+		if(strpbrk(text, ",\"\r\n") == NULL)
+		{
+			fputs(text, filePtr);
+			return;
+		}
+
+		fputc('"', filePtr);
+		for(const char* c = text; *c != '\0'; c++)
+		{
+			if(*c == '"')
+			{
+				fputc('"', filePtr);
+			}
+			fputc(*c, filePtr);
+		}
+		fputc('"', filePtr);
+	}
+
+	/// Converts nanoseconds to milliseconds.
+	static double toMillis(unsigned long value)
+	{
+		return (double)value / Constants::NANOS_PER_MILLI;
+	}
+
+	std::vector<ProfileSection*> sections;
+	std::vector<unsigned long> scratch;
+	std::atomic<bool> visible;
+
+	/// Guards the samples, which are recorded and read on different threads
+	std::mutex mutex;
+};
+
+/// ProfileScope
+///	 Times the enclosing scope and records it against a profiler section.
+class ProfileScope
+{
+public:
+	/// Starts timing a section.
+	///  @owner The profiler that receives the sample.
+	///  @section The identifier of the section.
+	ProfileScope(Profiler& owner, int section) :
+		profiler(owner)
+	{
+		id = section;
+		start = GameTime::getNow();
+	}
+
+	/// Stops timing and records the sample.
+	~ProfileScope(void)
+	{
+		profiler.add(id, GameTime::getNow() - start);
+	}
+
+private:
+	Profiler& profiler;
+	int id;
+	unsigned long start;
+};
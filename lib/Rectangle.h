@@ -11,6 +11,15 @@
 class Rectangle
 {
 public:
+	/// Initializes a new, empty instance of Rectangle.
+	Rectangle(void)
+	{
+		_x = 0;
+		_y = 0;
+		_width = 0;
+		_height = 0;
+	}
+
 	/// Initializes a new instance of Rectangle.
 	///  @x The x-coordinate of the rectangle.
 	///  @y The y-coordinate of the rectangle.
@@ -63,49 +72,49 @@ public:
 
 	/// Gets the width of the rectangle.
 	///  @returns Rectangle width.
-	float getWidth(void)
+	float getWidth(void) const
 	{
 		return _width;
 	}
 
 	/// Gets the height of the rectangle.
 	///  @returns Rectangle height.
-	float getHeight(void)
+	float getHeight(void) const
 	{
 		return _height;
 	}
 
 	/// Returns the y-coordinate of the bottom of the rectangle.
 	/// @returns The rectangle bottom y-coordinate.
-	float getBottom(void)
+	float getBottom(void) const
 	{
 		return _y + _width;
 	}
 
 	/// Returns the y-coordinate of the top of the rectangle.
 	/// @returns The rectangle top y-coordinate.
-	float getTop(void)
+	float getTop(void) const
 	{
 		return _y;
 	}
 
 	/// Returns the x-coordinate of the center of the rectangle.
 	/// @returns The rectangle center x-coordinate.
-	float getCenterX(void)
+	float getCenterX(void) const
 	{
 		return _x + (_width / 2.0f);
 	}
 
 	/// Returns the y-coordinate of the center of the rectangle.
 	/// @returns The rectangle center y-coordinate.
-	float getCenterY(void)
+	float getCenterY(void) const
 	{
 		return _y + (_height / 2.0f);
 	}
 
 	/// Gets the Point that specifies the center of the rectangle.
 	/// @returns The center coordinate.
-	Vector2 getCenter(void)
+	Vector2 getCenter(void) const
 	{
 		float halfWidth = _width / 2.0f;
 		float halfHeight = _height / 2.0f;
@@ -115,21 +124,21 @@ public:
 
 	/// Returns the x-coordinate of the left side of the rectangle.
 	///  @returns The rectangle left x-coordinate.
-	float getLeft(void)
+	float getLeft(void) const
 	{
 		return _x;
 	}
 
 	/// Returns the x-coordinate of the right side of the rectangle.
 	///  @returns The rectangle right x-coordinate.
-	float getRight(void)
+	float getRight(void) const
 	{
 		return _x + _width;
 	}
 
 	/// Gets the upper-left value of the Rectangle.
 	///  @returns The rectangle left x-coordinate.
-	float getLocation(void)
+	float getLocation(void) const
 	{
 		return _x;
 	}
@@ -138,7 +147,7 @@ public:
 	///  @rectA Source rectangle.
 	///  @rectB Source rectangle.
 	///  @returns Horizontal intersection depth.
-	static float getHorizontalIntersectionDepth(Rectangle rectA, Rectangle rectB)
+	static float getHorizontalIntersectionDepth(const Rectangle& rectA, const Rectangle& rectB)
 	{
 		// Calculate half sizes.
 		float halfWidthA = rectA.getWidth() / 2.0f;
@@ -164,7 +173,7 @@ public:
 	///  @rectA Source rectangle.
 	///  @rectB Source rectangle.
 	///  @returns Vertical intersection depth.
-	static float getVerticalIntersectionDepth(Rectangle rectA, Rectangle rectB)
+	static float getVerticalIntersectionDepth(const Rectangle& rectA, const Rectangle& rectB)
 	{
 		// Calculate half sizes.
 		float halfHeightA = rectA.getHeight() / 2.0f;
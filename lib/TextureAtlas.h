@@ -0,0 +1,249 @@
+#pragma once
+
+/// Standard libraries
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <map>
+
+/// X11/XLib libraries
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+
+/// Project components
+#include "Logger.h"
+
+namespace Logger
+{
+	/// Texture Atlas Messages
+	static const char* LOG_ATLASERROR = "Unable to read texture atlas.";
+	static const char* LOG_ATLASREGION = "# Texture atlas region lies outside its image: ";
+}
+
+/// AtlasRegion
+///	 The sub-rectangle of an atlas image occupied by a single sprite.
+struct AtlasRegion
+{
+	int x;
+	int y;
+	int width;
+	int height;
+};
+
+/// TextureAtlas
+///	 An irregular sheet of sprites described by a TextureAtlas XML file (<SubTexture name= x= y= width= height=>).
+///  Names are resolved to dense integer ids once when the atlas is loaded; drawing indexes the region array
+///  directly, so no string lookups happen in the frame loop.
+class TextureAtlas
+{
+public:
+	/// Creates a texture atlas over an image from its XML description.
+	///  @image The image holding every sprite of the atlas.
+	///  @filename The path of the TextureAtlas XML file.
+	TextureAtlas(XImage* image, const char* filename)
+	{
+		img = image;
+
+		std::string text;
+		if(!readFile(filename, &text))
+		{
+			Logger::application_error(Logger::LOG_ATLASERROR);
+		}
+		parse(text);
+	}
+
+	/// Resolves a sprite name to its id.  Intended for load time; keep the id rather than the name.
+	///  @name The name of the sprite, as it appears in the XML file.
+	///  @returns The id of the sprite, or -1 if the atlas does not contain the name.
+	int getId(const char* name)
+	{
+		std::map<std::string, int>::const_iterator it = ids.find(name);
+		if(it == ids.end())
+		{
+			return -1;
+		}
+		return it->second;
+	}
+
+	/// Gets the name of a sprite.
+	///  @id The id of the sprite.
+	///  @returns The name of the sprite.
+	const char* getName(int id)
+	{
+		return names[id].c_str();
+	}
+
+	/// Gets the image region of a sprite.
+	///  @id The id of the sprite.
+	///  @returns The region of the atlas image holding the sprite.
+	const AtlasRegion& getRegion(int id)
+	{
+		return regions[id];
+	}
+
+	/// Gets the image coordinate position from an id.
+	///  @id The id of the sprite.
+	///  @sourceX The image horizontal position in the atlas.
+	///  @sourceY The image vertical position in the atlas.
+	void getInfo(int id, int* sourceX, int* sourceY)
+	{
+		if(id < 0 || id >= (int)regions.size())
+			return;
+
+		*sourceX = regions[id].x;
+		*sourceY = regions[id].y;
+	}
+
+	/// Get the number of sprites in the atlas.
+	///  @returns The number of sprites, one more than the largest id.
+	int getCount(void)
+	{
+		return regions.size();
+	}
+
+	/// Returns the underlying image of the atlas.
+	///  @returns The underlying atlas image.
+	XImage* getImage(void)
+	{
+		return img;
+	}
+
+	/// Gets the image path recorded in the XML file.
+	///  @returns The image path, which names the art the atlas was cut from.
+	const char* getImagePath(void)
+	{
+		return imagePath.c_str();
+	}
+
+private:
+	/// Reads a whole file into a string.
+	static bool readFile(const char* filename, std::string* text)
+	{
+		FILE* filePtr = fopen(filename, "rb");
+		if(filePtr == NULL)
+		{
+			return false;
+		}
+
+		char buffer[4096];
+		size_t length;
+		while((length = fread(buffer, 1, sizeof(buffer), filePtr)) > 0)
+		{
+			text->append(buffer, length);
+		}
+
+		bool failed = ferror(filePtr) != 0;
+		fclose(filePtr);
+		return !failed;
+	}
+
+	/// Reads the value of an attribute from the text of an element.
+	///  @element The text between the element's '<' and '>'.
+	///  @name The attribute name.
+	///  @value The attribute value.
+	///  @returns True if the element has the attribute, false otherwise.
+	static bool getAttribute(const std::string& element, const char* name, std::string* value)
+	{
+		std::string key = std::string(name) + "=\"";
+
+		// the name must start the attribute, so 'x' does not match the end of another attribute's name
+		size_t start = std::string::npos;
+		for(size_t pos = element.find(key); pos != std::string::npos; pos = element.find(key, pos + 1))
+		{
+			if(pos > 0 && isspace((unsigned char)element[pos - 1]))
+			{
+				start = pos + key.length();
+				break;
+			}
+		}
+		if(start == std::string::npos)
+		{
+			return false;
+		}
+
+		size_t end = element.find('"', start);
+		if(end == std::string::npos)
+		{
+			return false;
+		}
+		value->assign(element, start, end - start);
+		return true;
+	}
+
+	/// Reads an integer attribute from the text of an element.
+	static bool getAttribute(const std::string& element, const char* name, int* value)
+	{
+		std::string text;
+		if(!getAttribute(element, name, &text) || text.empty())
+		{
+			return false;
+		}
+
+		char* end;
+		*value = strtol(text.c_str(), &end, 10);
+		return *end == 0;
+	}
+
+	/// Builds the region array and name table from the XML text.  Ids follow the order of the file.
+	void parse(const std::string& text)
+	{
+		size_t pos = text.find("<TextureAtlas");
+		if(pos == std::string::npos)
+		{
+			Logger::application_error(Logger::LOG_ATLASERROR);
+		}
+
+		size_t end = text.find('>', pos);
+		getAttribute(text.substr(pos, end - pos), "imagePath", &imagePath);
+
+		while((pos = text.find("<SubTexture", end)) != std::string::npos)
+		{
+			end = text.find('>', pos);
+			if(end == std::string::npos)
+			{
+				Logger::application_error(Logger::LOG_ATLASERROR);
+			}
+			std::string element = text.substr(pos, end - pos);
+
+			std::string name;
+			AtlasRegion region;
+			if(!getAttribute(element, "name", &name) ||
+				!getAttribute(element, "x", &region.x) ||
+				!getAttribute(element, "y", &region.y) ||
+				!getAttribute(element, "width", &region.width) ||
+				!getAttribute(element, "height", &region.height))
+			{
+				Logger::application_error(Logger::LOG_ATLASERROR);
+			}
+
+			// a region outside the image would read past its pixels when drawn
+			if(region.x < 0 || region.y < 0 || region.width <= 0 || region.height <= 0 ||
+				(img != NULL && (region.x + region.width > img->width || region.y + region.height > img->height)))
+			{
+				Logger::application_debug(Logger::LOG_ATLASREGION, name.c_str());
+				region.width = 0;
+				region.height = 0;
+			}
+
+			if(ids.find(name) == ids.end())
+			{
+				ids[name] = regions.size();
+			}
+			names.push_back(name);
+			regions.push_back(region);
+		}
+	}
+
+	// Sprite regions indexed by id
+	std::vector<AtlasRegion> regions;
+
+	// Sprite names indexed by id, and the reverse lookup used at load time
+	std::vector<std::string> names;
+	std::map<std::string, int> ids;
+
+	std::string imagePath;
+	XImage* img;
+};
@@ -0,0 +1,403 @@
+#pragma once
+
+/// Standard libraries
+#include <stdint.h>
+#include <cstring>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/// SIMD intrinsics
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace Constants
+{
+	/// The alpha value at or above which a pixel is inside a derived clip mask.
+	static const unsigned char MASK_ALPHA_THRESHOLD = 128;
+}
+
+/// TgaHeader
+///	 The fixed 18 byte header at the start of a TGA file.
+#pragma pack(push, 1)
+struct TgaHeader
+{
+	unsigned char idLength;
+	unsigned char colorMapType;
+	unsigned char imageType;
+	unsigned char colorMapSpec[5];
+	unsigned short xOrigin;
+	unsigned short yOrigin;
+	unsigned short width;
+	unsigned short height;
+	unsigned char bitsPerPixel;
+	unsigned char descriptor;
+};
+#pragma pack(pop)
+
+/// TgaDecoder
+///	 Decodes uncompressed and run-length encoded true-colour (24/32-bit) and greyscale (8-bit) TGA images
+///  from a memory-mapped file into 32-bit BGRA rows.  Images without alpha are made opaque.
+class TgaDecoder
+{
+public:
+	/// Initializes a new instance of TgaDecoder.
+	TgaDecoder(void)
+	{
+		file = NULL;
+		fileSize = 0;
+		header = NULL;
+	}
+
+	/// Disposes of the TgaDecoder instance, unmapping the file.
+	~TgaDecoder(void)
+	{
+		close();
+	}
+
+	/// Maps a file and validates its header.
+	///  @filename The path of the TGA file.
+	///  @returns True if the file is a supported TGA image, false otherwise.
+	bool open(const char* filename)
+	{
+		close();
+
+		int fd = ::open(filename, O_RDONLY);
+		if(fd < 0)
+		{
+			return false;
+		}
+
+		struct stat info;
+		if(fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(TgaHeader))
+		{
+			::close(fd);
+			return false;
+		}
+
+		void* mapping = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		::close(fd);
+		if(mapping == MAP_FAILED)
+		{
+			return false;
+		}
+
+		file = (const unsigned char*)mapping;
+		fileSize = info.st_size;
+		header = (const TgaHeader*)file;
+
+		if(!isSupported())
+		{
+			close();
+			return false;
+		}
+		return true;
+	}
+
+	/// Unmaps the file.
+	void close(void)
+	{
+		if(file != NULL)
+		{
+			munmap((void*)file, fileSize);
+		}
+		file = NULL;
+		fileSize = 0;
+		header = NULL;
+	}
+
+	/// Gets the width of the image.
+	///  @returns The image width.
+	int getWidth(void)
+	{
+		return header->width;
+	}
+
+	/// Gets the height of the image.
+	///  @returns The image height.
+	int getHeight(void)
+	{
+		return header->height;
+	}
+
+	/// Decodes the image into 32-bit BGRA rows, top row first.
+	///  @dst The first row of the destination.
+	///  @stride The distance (in bytes) between destination rows.
+	///  @returns True if successful, false if the pixel data is truncated.
+	bool decode(char* dst, int stride)
+	{
+		const unsigned char* src = file + sizeof(TgaHeader) + header->idLength;
+		const unsigned char* end = file + fileSize;
+		if(isRunLength())
+		{
+			return decodeRunLength(src, end, dst, stride);
+		}
+
+		int width = header->width;
+		int pixelSize = header->bitsPerPixel / 8;
+		size_t rowLength = (size_t)width * pixelSize;
+		if((size_t)(end - src) < rowLength * header->height)
+		{
+			return false;
+		}
+
+		for(int row = 0; row < header->height; row++)
+		{
+			expandRow((uint32_t*)getRow(dst, stride, row), src + row * rowLength, width, pixelSize);
+		}
+		return true;
+	}
+
+	/// Builds a clip mask in XBM layout (rows of bytes, least significant bit first) from the alpha of an image.
+	///  @pixels The first row of the 32-bit BGRA image.
+	///  @stride The distance (in bytes) between image rows.
+	///  @width The width of the image.
+	///  @height The height of the image.
+	///  @bits The mask rows, (width + 7) / 8 bytes each.
+	static void getAlphaMask(const char* pixels, int stride, int width, int height, unsigned char* bits)
+	{
+		int maskStride = (width + 7) / 8;
+		for(int row = 0; row < height; row++)
+		{
+			const uint32_t* src = (const uint32_t*)(pixels + row * stride);
+			unsigned char* dst = bits + row * maskStride;
+			memset(dst, 0, maskStride);
+
+			int x = 0;
+#if defined(__SSE2__)
+			// a threshold of 128 is the sign bit of each alpha byte once the alphas are packed together
+			if(Constants::MASK_ALPHA_THRESHOLD == 128)
+			{
+				for(; x + 16 <= width; x += 16)
+				{
+					__m128i a0 = _mm_srli_epi32(_mm_loadu_si128((const __m128i*)(src + x)), 24);
+					__m128i a1 = _mm_srli_epi32(_mm_loadu_si128((const __m128i*)(src + x + 4)), 24);
+					__m128i a2 = _mm_srli_epi32(_mm_loadu_si128((const __m128i*)(src + x + 8)), 24);
+					__m128i a3 = _mm_srli_epi32(_mm_loadu_si128((const __m128i*)(src + x + 12)), 24);
+					__m128i alpha = _mm_packus_epi16(_mm_packs_epi32(a0, a1), _mm_packs_epi32(a2, a3));
+
+					int mask = _mm_movemask_epi8(alpha);
+					dst[x / 8] = mask & 0xFF;
+					dst[x / 8 + 1] = (mask >> 8) & 0xFF;
+				}
+			}
+#endif
+			for(; x < width; x++)
+			{
+				if((src[x] >> 24) >= Constants::MASK_ALPHA_THRESHOLD)
+				{
+					dst[x / 8] |= 1 << (x % 8);
+				}
+			}
+		}
+	}
+
+private:
+	/// Image types and descriptor bits of the TGA format.
+	static const int TYPE_TRUECOLOR = 2;
+	static const int TYPE_GREYSCALE = 3;
+	static const int TYPE_RLE_TRUECOLOR = 10;
+	static const int TYPE_RLE_GREYSCALE = 11;
+	static const int DESCRIPTOR_RIGHT_TO_LEFT = 0x10;
+	static const int DESCRIPTOR_TOP_TO_BOTTOM = 0x20;
+
+	/// Returns true if the header describes an image the decoder can handle.
+	bool isSupported(void)
+	{
+		if(header->colorMapType != 0 || (header->descriptor & DESCRIPTOR_RIGHT_TO_LEFT) != 0)
+		{
+			return false;
+		}
+		if(header->width == 0 || header->height == 0)
+		{
+			return false;
+		}
+
+		switch(header->imageType)
+		{
+		case TYPE_TRUECOLOR:
+		case TYPE_RLE_TRUECOLOR:
+			return header->bitsPerPixel == 24 || header->bitsPerPixel == 32;
+		case TYPE_GREYSCALE:
+		case TYPE_RLE_GREYSCALE:
+			return header->bitsPerPixel == 8;
+		}
+		return false;
+	}
+
+	/// Returns true if the pixel data is run-length encoded.
+	bool isRunLength(void)
+	{
+		return header->imageType == TYPE_RLE_TRUECOLOR || header->imageType == TYPE_RLE_GREYSCALE;
+	}
+
+	/// Gets the destination row of a stored row, flipping images stored bottom row first.
+	char* getRow(char* dst, int stride, int row)
+	{
+		if((header->descriptor & DESCRIPTOR_TOP_TO_BOTTOM) == 0)
+		{
+			row = header->height - 1 - row;
+		}
+		return dst + (size_t)row * stride;
+	}
+
+	/// Decodes run-length packets.  Packets may run across row boundaries.
+	bool decodeRunLength(const unsigned char* src, const unsigned char* end, char* dst, int stride)
+	{
+		int width = header->width;
+		int pixelSize = header->bitsPerPixel / 8;
+
+		int row = 0;
+		int column = 0;
+		uint32_t* out = (uint32_t*)getRow(dst, stride, row);
+
+		while(row < header->height)
+		{
+			if(src >= end)
+			{
+				return false;
+			}
+
+			unsigned char packet = *src++;
+			int count = (packet & 0x7F) + 1;
+			bool repeated = (packet & 0x80) != 0;
+
+			size_t packetLength = repeated ? pixelSize : (size_t)count * pixelSize;
+			if((size_t)(end - src) < packetLength)
+			{
+				return false;
+			}
+
+			while(count > 0 && row < header->height)
+			{
+				int span = count < width - column ? count : width - column;
+				if(repeated)
+				{
+					uint32_t pixel;
+					expandRow(&pixel, src, 1, pixelSize);
+					std::fill(out + column, out + column + span, pixel);
+				}
+				else
+				{
+					expandRow(out + column, src, span, pixelSize);
+					src += span * pixelSize;
+				}
+
+				count -= span;
+				column += span;
+				if(column == width)
+				{
+					column = 0;
+					row++;
+					if(row < header->height)
+					{
+						out = (uint32_t*)getRow(dst, stride, row);
+					}
+				}
+			}
+
+			if(repeated)
+			{
+				src += pixelSize;
+			}
+		}
+		return true;
+	}
+
+	/// Expands a run of 8, 24 or 32-bit source pixels to 32-bit BGRA.
+	static void expandRow(uint32_t* dst, const unsigned char* src, int count, int pixelSize)
+	{
+		switch(pixelSize)
+		{
+		case 4:
+			memcpy(dst, src, (size_t)count * 4);
+			break;
+		case 3:
+			getExpandBGR()(dst, src, count);
+			break;
+		default:
+			expandGrey(dst, src, count);
+			break;
+		}
+	}
+
+	/// Expands a row of BGR pixels.
+	typedef void (*ExpandRow)(uint32_t* dst, const unsigned char* src, int count);
+
+	/// Expands BGR to opaque BGRA one pixel at a time.
+	static void expandBGRScalar(uint32_t* dst, const unsigned char* src, int count)
+	{
+		for(int i = 0; i < count; i++, src += 3)
+		{
+			dst[i] = 0xFF000000u | (src[2] << 16) | (src[1] << 8) | src[0];
+		}
+	}
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+	/// Expands BGR to opaque BGRA four pixels at a time with a byte shuffle.
+	__attribute__((target("ssse3")))
+	static void expandBGRSSSE3(uint32_t* dst, const unsigned char* src, int count)
+	{
+		const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+		const __m128i alpha = _mm_set1_epi32(0xFF000000);
+
+		// each step reads 16 bytes but consumes 12, so stop while a full load is still in bounds
+		int i = 0;
+		for(; i + 6 <= count; i += 4)
+		{
+			__m128i bgr = _mm_loadu_si128((const __m128i*)(src + i * 3));
+			_mm_storeu_si128((__m128i*)(dst + i), _mm_or_si128(_mm_shuffle_epi8(bgr, shuffle), alpha));
+		}
+
+		expandBGRScalar(dst + i, src + i * 3, count - i);
+	}
+#define XGAMELIB_SSSE3 1
+#endif
+
+	/// Selects the fastest BGR expansion the CPU supports.
+	static ExpandRow getExpandBGR(void)
+	{
+#if defined(XGAMELIB_SSSE3)
+		static ExpandRow expand = __builtin_cpu_supports("ssse3") ? expandBGRSSSE3 : expandBGRScalar;
+		return expand;
+#else
+		return expandBGRScalar;
+#endif
+	}
+
+	/// Expands greyscale to opaque BGRA.
+	static void expandGrey(uint32_t* dst, const unsigned char* src, int count)
+	{
+		int i = 0;
+#if defined(__SSE2__)
+		const __m128i opaque = _mm_set1_epi8((char)0xFF);
+		for(; i + 16 <= count; i += 16)
+		{
+			__m128i grey = _mm_loadu_si128((const __m128i*)(src + i));
+
+			// interleave to G G and G A pairs, then to G G G A pixels
+			__m128i gg0 = _mm_unpacklo_epi8(grey, grey);
+			__m128i gg1 = _mm_unpackhi_epi8(grey, grey);
+			__m128i ga0 = _mm_unpacklo_epi8(grey, opaque);
+			__m128i ga1 = _mm_unpackhi_epi8(grey, opaque);
+
+			_mm_storeu_si128((__m128i*)(dst + i), _mm_unpacklo_epi16(gg0, ga0));
+			_mm_storeu_si128((__m128i*)(dst + i + 4), _mm_unpackhi_epi16(gg0, ga0));
+			_mm_storeu_si128((__m128i*)(dst + i + 8), _mm_unpacklo_epi16(gg1, ga1));
+			_mm_storeu_si128((__m128i*)(dst + i + 12), _mm_unpackhi_epi16(gg1, ga1));
+		}
+#endif
+		for(; i < count; i++)
+		{
+			uint32_t g = src[i];
+			dst[i] = 0xFF000000u | (g << 16) | (g << 8) | g;
+		}
+	}
+
+	const unsigned char* file;
+	size_t fileSize;
+	const TgaHeader* header;
+};
@@ -0,0 +1,421 @@
+#pragma once
+
+/// Standard libraries
+#include <cstdlib>
+#include <cstring>
+#include <stdint.h>
+#include <vector>
+#include <algorithm>
+
+/// Project components
+#include "Logger.h"
+
+namespace Constants
+{
+	/// The width and height (in tiles) of a tile map chunk, as a power of two.
+	static const int TILE_CHUNK_SHIFT = 5;
+	static const int TILE_CHUNK_SIZE = 1 << TILE_CHUNK_SHIFT;
+	static const int TILE_CHUNK_MASK = TILE_CHUNK_SIZE - 1;
+
+	/// The bytes of a chunk buffer: the tiles, followed by a row bitmap of the flagged tiles.
+	static const int TILE_CHUNK_BYTES = TILE_CHUNK_SIZE * TILE_CHUNK_SIZE + TILE_CHUNK_SIZE * sizeof(uint32_t);
+}
+
+/// TileMap
+///	 A grid of byte-sized tiles stored in fixed-size square chunks.  Chunks holding only the empty tile are not
+///  stored at all.  A map can be backed by a full tile layer (such as a memory-mapped level), in which case
+///  chunks are copied in from it the first time they are touched and unmodified chunks can be evicted again,
+///  so only the chunks around the player need to be resident.  Each resident chunk also keeps a bitmap per row
+///  of the tiles carrying a flag (such as solidity), so a run of cells can be tested with a few bit operations;
+///  cells outside the map always read as flagged, acting as a border of sentinels.
+class TileMap
+{
+public:
+	/// Initializes a new instance of TileMap.
+	///  @empty The tile value of empty cells.
+	TileMap(uint8_t empty)
+	{
+		emptyTile = empty;
+		width = 0;
+		height = 0;
+		chunksX = 0;
+		chunksY = 0;
+		source = NULL;
+		flagTable = NULL;
+		flagMask = 0;
+		emptyRow = 0;
+	}
+
+	/// Disposes of the TileMap instance.
+	~TileMap(void)
+	{
+		release();
+		for(size_t i = 0; i < freeChunks.size(); i++)
+		{
+			free(freeChunks[i]);
+		}
+	}
+
+	/// Sets which tiles are flagged in the row bitmaps.  Takes effect from the next reset.
+	///  @table The flags of every tile value (256 entries), which must outlive the map.
+	///  @mask The flag bits that mark a tile.
+	void setFlags(const uint8_t* table, uint8_t mask)
+	{
+		flagTable = table;
+		flagMask = mask;
+	}
+
+	/// Discards every tile and resizes the map.
+	///  @mapWidth The width of the map in tiles.
+	///  @mapHeight The height of the map in tiles.
+	///  @layer The backing tile layer (mapWidth * mapHeight tiles, row-major), or NULL for an empty map.
+	///   The layer is read until the next reset, so it must remain valid until then.
+	void reset(int mapWidth, int mapHeight, const uint8_t* layer)
+	{
+		release();
+
+		width = mapWidth;
+		height = mapHeight;
+		chunksX = (width + Constants::TILE_CHUNK_MASK) >> Constants::TILE_CHUNK_SHIFT;
+		chunksY = (height + Constants::TILE_CHUNK_MASK) >> Constants::TILE_CHUNK_SHIFT;
+		source = layer;
+		emptyRow = isFlagged(emptyTile) ? ~0u : 0u;
+
+		Chunk chunk;
+		chunk.tiles = NULL;
+		chunk.state = source != NULL ? CHUNK_UNLOADED : CHUNK_EMPTY;
+		chunks.assign((size_t)chunksX * chunksY, chunk);
+	}
+
+	/// Gets the tile at a cell.
+	///  @x The column of the cell.
+	///  @y The row of the cell.
+	///  @returns The tile value.
+	uint8_t get(int x, int y)
+	{
+		Chunk& chunk = getChunk(x, y);
+		if(chunk.tiles == NULL)
+		{
+			if(chunk.state != CHUNK_UNLOADED || !load(x >> Constants::TILE_CHUNK_SHIFT, y >> Constants::TILE_CHUNK_SHIFT))
+			{
+				return emptyTile;
+			}
+		}
+		return chunk.tiles[getOffset(x, y)];
+	}
+
+	/// Sets the tile at a cell.  A modified chunk stays resident until the map is reset.
+	///  @x The column of the cell.
+	///  @y The row of the cell.
+	///  @tile The tile value.
+	void set(int x, int y, uint8_t tile)
+	{
+		Chunk& chunk = getChunk(x, y);
+		if(chunk.tiles == NULL)
+		{
+			if(chunk.state == CHUNK_UNLOADED)
+			{
+				load(x >> Constants::TILE_CHUNK_SHIFT, y >> Constants::TILE_CHUNK_SHIFT);
+			}
+			if(chunk.tiles == NULL)
+			{
+				if(tile == emptyTile)
+				{
+					return;
+				}
+				chunk.tiles = allocateChunk();
+				memset(chunk.tiles, emptyTile, Constants::TILE_CHUNK_SIZE * Constants::TILE_CHUNK_SIZE);
+				uint32_t* rows = getRows(chunk.tiles);
+				for(int row = 0; row < Constants::TILE_CHUNK_SIZE; row++)
+				{
+					rows[row] = emptyRow;
+				}
+				resident.push_back(&chunk - &chunks[0]);
+			}
+		}
+
+		chunk.tiles[getOffset(x, y)] = tile;
+		chunk.state = CHUNK_MODIFIED;
+
+		uint32_t bit = 1u << (x & Constants::TILE_CHUNK_MASK);
+		uint32_t& row = getRows(chunk.tiles)[y & Constants::TILE_CHUNK_MASK];
+		row = isFlagged(tile) ? (row | bit) : (row & ~bit);
+	}
+
+	/// Gets the flags of a run of cells in a row as a bitmap.  Cells outside the map are flagged.
+	///  @x The column of the first cell.
+	///  @y The row of the cells.
+	///  @count The number of cells, at most 32.
+	///  @returns A bitmap with bit i set if cell (x + i, y) is flagged.
+	uint32_t getFlagRow(int x, int y, int count)
+	{
+		if(y < 0 || y >= height)
+		{
+			return getRunMask(count);
+		}
+
+		// the run covers the left border, at most two chunks, and the right border
+		uint32_t result = 0;
+		int filled = 0;
+		while(filled < count)
+		{
+			int column = x + filled;
+			int run = count - filled;
+			uint32_t bits;
+
+			if(column < 0)
+			{
+				run = std::min(run, -column);
+				bits = getRunMask(run);
+			}
+			else if(column >= width)
+			{
+				bits = getRunMask(run);
+			}
+			else
+			{
+				int offset = column & Constants::TILE_CHUNK_MASK;
+				run = std::min(run, std::min(Constants::TILE_CHUNK_SIZE - offset, width - column));
+				bits = (getChunkRow(column, y) >> offset) & getRunMask(run);
+			}
+
+			result |= bits << filled;
+			filled += run;
+		}
+		return result;
+	}
+
+	/// Evicts the unmodified chunks further than a radius from a cell.  They are copied in again from the
+	/// backing layer if they are touched later.
+	///  @x The column of the cell to keep resident.
+	///  @y The row of the cell to keep resident.
+	///  @radius The number of chunks to keep around the cell's chunk.
+	void evict(int x, int y, int radius)
+	{
+		if(source == NULL)
+		{
+			return;
+		}
+
+		int centerX = x >> Constants::TILE_CHUNK_SHIFT;
+		int centerY = y >> Constants::TILE_CHUNK_SHIFT;
+
+		size_t kept = 0;
+		for(size_t i = 0; i < resident.size(); i++)
+		{
+			int index = resident[i];
+			Chunk& chunk = chunks[index];
+			int chunkX = index % chunksX;
+			int chunkY = index / chunksX;
+
+			if(chunk.state == CHUNK_MODIFIED || (abs(chunkX - centerX) <= radius && abs(chunkY - centerY) <= radius))
+			{
+				resident[kept++] = index;
+				continue;
+			}
+
+			freeChunks.push_back(chunk.tiles);
+			chunk.tiles = NULL;
+			chunk.state = CHUNK_UNLOADED;
+		}
+		resident.resize(kept);
+	}
+
+	/// Gets the width of the map.
+	///  @returns The width in tiles.
+	int getWidth(void)
+	{
+		return width;
+	}
+
+	/// Gets the height of the map.
+	///  @returns The height in tiles.
+	int getHeight(void)
+	{
+		return height;
+	}
+
+	/// Gets the number of chunks holding tiles in memory.
+	///  @returns The resident chunk count.
+	size_t getResidentCount(void)
+	{
+		return resident.size();
+	}
+
+	/// Gets the memory held by the map: the chunk table, resident chunks and chunks kept for reuse.
+	///  @returns The size in bytes.
+	size_t getMemoryUsage(void)
+	{
+		size_t chunkBytes = Constants::TILE_CHUNK_BYTES;
+		return chunks.capacity() * sizeof(Chunk) + (resident.size() + freeChunks.size()) * chunkBytes;
+	}
+
+private:
+	/// The residency of a chunk.  Empty chunks hold no tiles; unloaded chunks have not been read from the layer.
+	enum ChunkState
+	{
+		CHUNK_UNLOADED,
+		CHUNK_EMPTY,
+		CHUNK_LOADED,
+		CHUNK_MODIFIED
+	};
+
+	/// A square of tiles, row-major.
+	struct Chunk
+	{
+		uint8_t* tiles;
+		uint8_t state;
+	};
+
+	/// Gets the row bitmap following the tiles of a chunk buffer.
+	static uint32_t* getRows(uint8_t* tiles)
+	{
+		return (uint32_t*)(tiles + Constants::TILE_CHUNK_SIZE * Constants::TILE_CHUNK_SIZE);
+	}
+
+	/// Gets a bitmap with the low count bits set.
+	static uint32_t getRunMask(int count)
+	{
+		return count >= 32 ? ~0u : (1u << count) - 1;
+	}
+
+	/// Returns true if a tile carries the flag of the row bitmaps.
+	bool isFlagged(uint8_t tile)
+	{
+		return flagTable != NULL && (flagTable[tile] & flagMask) != 0;
+	}
+
+	/// Gets the bitmap of the chunk row holding a cell, loading the chunk if needed.
+	uint32_t getChunkRow(int x, int y)
+	{
+		Chunk& chunk = getChunk(x, y);
+		if(chunk.tiles == NULL)
+		{
+			if(chunk.state != CHUNK_UNLOADED || !load(x >> Constants::TILE_CHUNK_SHIFT, y >> Constants::TILE_CHUNK_SHIFT))
+			{
+				return emptyRow;
+			}
+		}
+		return getRows(chunk.tiles)[y & Constants::TILE_CHUNK_MASK];
+	}
+
+	/// Gets the chunk holding a cell.
+	Chunk& getChunk(int x, int y)
+	{
+		return chunks[(y >> Constants::TILE_CHUNK_SHIFT) * chunksX + (x >> Constants::TILE_CHUNK_SHIFT)];
+	}
+
+	/// Gets the offset of a cell within its chunk.
+	static int getOffset(int x, int y)
+	{
+		return ((y & Constants::TILE_CHUNK_MASK) << Constants::TILE_CHUNK_SHIFT) | (x & Constants::TILE_CHUNK_MASK);
+	}
+
+	/// Copies a chunk in from the backing layer, unless it only holds empty tiles.
+	///  @returns True if the chunk holds tiles, false if it is empty.
+	bool load(int chunkX, int chunkY)
+	{
+		Chunk& chunk = chunks[chunkY * chunksX + chunkX];
+
+		int left = chunkX << Constants::TILE_CHUNK_SHIFT;
+		int bottom = chunkY << Constants::TILE_CHUNK_SHIFT;
+		int columns = std::min(Constants::TILE_CHUNK_SIZE, width - left);
+		int rows = std::min(Constants::TILE_CHUNK_SIZE, height - bottom);
+
+		bool empty = true;
+		for(int row = 0; row < rows && empty; row++)
+		{
+			const uint8_t* line = source + (size_t)(bottom + row) * width + left;
+			for(int column = 0; column < columns; column++)
+			{
+				if(line[column] != emptyTile)
+				{
+					empty = false;
+					break;
+				}
+			}
+		}
+
+		if(empty)
+		{
+			chunk.state = CHUNK_EMPTY;
+			return false;
+		}
+
+		chunk.tiles = allocateChunk();
+		if(columns < Constants::TILE_CHUNK_SIZE || rows < Constants::TILE_CHUNK_SIZE)
+		{
+			memset(chunk.tiles, emptyTile, Constants::TILE_CHUNK_SIZE * Constants::TILE_CHUNK_SIZE);
+		}
+		for(int row = 0; row < rows; row++)
+		{
+			memcpy(chunk.tiles + (row << Constants::TILE_CHUNK_SHIFT), source + (size_t)(bottom + row) * width + left, columns);
+		}
+
+		// padding cells past the map edge hold the empty tile; getFlagRow never reads their bits
+		uint32_t* bitmap = getRows(chunk.tiles);
+		for(int row = 0; row < Constants::TILE_CHUNK_SIZE; row++)
+		{
+			const uint8_t* line = chunk.tiles + (row << Constants::TILE_CHUNK_SHIFT);
+			uint32_t bits = 0;
+			for(int column = 0; column < Constants::TILE_CHUNK_SIZE; column++)
+			{
+				if(isFlagged(line[column]))
+				{
+					bits |= 1u << column;
+				}
+			}
+			bitmap[row] = bits;
+		}
+
+		chunk.state = CHUNK_LOADED;
+		resident.push_back(chunkY * chunksX + chunkX);
+		return true;
+	}
+
+	/// Takes a chunk buffer, reusing an evicted one when possible.
+	uint8_t* allocateChunk(void)
+	{
+		if(!freeChunks.empty())
+		{
+			uint8_t* tiles = freeChunks.back();
+			freeChunks.pop_back();
+			return tiles;
+		}
+
+		uint8_t* tiles = (uint8_t*)malloc(Constants::TILE_CHUNK_BYTES);
+		if(tiles == NULL)
+		{
+			Logger::application_error("Can't allocate a tile map chunk.");
+		}
+		return tiles;
+	}
+
+	/// Returns every resident chunk to the free list.
+	void release(void)
+	{
+		for(size_t i = 0; i < resident.size(); i++)
+		{
+			freeChunks.push_back(chunks[resident[i]].tiles);
+		}
+		resident.clear();
+		chunks.clear();
+	}
+
+	int width;
+	int height;
+	int chunksX;
+	int chunksY;
+	uint8_t emptyTile;
+	const uint8_t* source;
+
+	// The flags marking tiles in the row bitmaps, and the bitmap of a row of empty tiles
+	const uint8_t* flagTable;
+	uint8_t flagMask;
+	uint32_t emptyRow;
+
+	// The chunk table, row-major by chunk, the chunks holding tiles, and buffers kept for reuse
+	std::vector<Chunk> chunks;
+	std::vector<int> resident;
+	std::vector<uint8_t*> freeChunks;
+};
@@ -0,0 +1,69 @@
+#pragma once
+
+/// Standard libraries
+#include <atomic>
+
+namespace Constants
+{
+	/// The number of slots a triple-buffered value is kept in.
+	static const int TRIPLE_BUFFER_SLOTS = 3;
+}
+
+/// TripleBuffer
+///	 Hands the latest of a series of snapshots from one writer thread to one reader thread without locks or
+///  waiting.  The snapshots live in an array of TRIPLE_BUFFER_SLOTS kept by the caller; the buffer only decides
+///  which slot each side may use.  The writer fills the back slot and publishes it; the reader acquires the most
+///  recently published slot as its front slot, which the writer will not touch until the reader acquires again.
+///  Snapshots published faster than they are read are overwritten.
+class TripleBuffer
+{
+public:
+	/// Initializes a new instance of TripleBuffer.  Nothing has been published, so the front slot is empty.
+	TripleBuffer(void) :
+		middle(1)
+	{
+		front = 0;
+		back = 2;
+	}
+
+	/// Gets the slot the writer fills next.
+	///  @returns The index of the back slot.
+	int getBack(void)
+	{
+		return back;
+	}
+
+	/// Publishes the back slot and takes another to fill.  Called by the writer.
+	void publish(void)
+	{
+		back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX;
+	}
+
+	/// Takes the most recently published slot, if anything was published since the last call.  Called by the reader.
+	///  @returns True if the front slot changed; false otherwise.
+	bool acquire(void)
+	{
+		if((middle.load(std::memory_order_relaxed) & FRESH) == 0)
+		{
+			return false;
+		}
+		front = middle.exchange(front, std::memory_order_acq_rel) & INDEX;
+		return true;
+	}
+
+	/// Gets the slot the reader draws from.
+	///  @returns The index of the front slot.
+	int getFront(void)
+	{
+		return front;
+	}
+
+private:
+	/// The middle slot is marked when it holds a snapshot the reader has not acquired
+	static const int INDEX = 3;
+	static const int FRESH = 4;
+
+	int front;
+	std::atomic<int> middle;
+	int back;
+};
@@ -27,14 +27,14 @@ public:
 
 	/// Gets the x-component of the vector.
 	///  @returns The horizontal component of the vector.
-	float getX(void)
+	float getX(void) const
 	{
 		return _x;
 	}
 
 	/// Gets the y-component of the vector.
 	///  @returns The vertical component of the vector.
-	float getY(void)
+	float getY(void) const
 	{
 		return _y;
 	}
@@ -75,10 +75,10 @@ public:
 	///  @value1 Source vector. 
 	///  @value2 Source vector.
 	///  @returns Distance between the two vectors.
-	static float distance(Vector2* value1, Vector2* value2) 
+	static float distance(const Vector2& value1, const Vector2& value2) 
 	{
-		float xd = value1->_x - value2->_x;
-		float yd = value1->_y - value2->_y;
+		float xd = value1._x - value2._x;
+		float yd = value1._y - value2._y;
 		return sqrt(xd * xd + yd * yd);
 	}
 
@@ -86,18 +86,18 @@ public:
 	///  @value1 Source vector. 
 	///  @value2 Source vector.
 	///  @returns Sum of the source vectors.
-	static Vector2* add(Vector2* value1, Vector2* value2) 
+	static Vector2 add(const Vector2& value1, const Vector2& value2) 
 	{
-		return new Vector2(value1->_x + value2->_x, value1->_y + value2->_y);
+		return Vector2(value1._x + value2._x, value1._y + value2._y);
 	}
 
 	/// Subtracts a vector from a vector.
 	///  @value1 Source vector. 
 	///  @value2 Source vector.
 	///  @returns Result of the subtraction.
-	static Vector2* sub(Vector2* value1, Vector2* value2) 
+	static Vector2 sub(const Vector2& value1, const Vector2& value2) 
 	{
-		return new Vector2(value1->_x - value2->_x, value1->_y - value2->_y);
+		return Vector2(value1._x - value2._x, value1._y - value2._y);
 	}
 
 private:
@@ -1,15 +1,33 @@
 #pragma once
 
 #include <unistd.h>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <sys/ipc.h>
+#include <sys/shm.h>
 
 #include <X11/Xlib.h>
 #include <X11/Xutil.h>
 #include <X11/keysymdef.h>
+#include <X11/extensions/XShm.h>
+#include <X11/extensions/Xrender.h>
 
 #include "Spritesheet.h"
+#include "TextureAtlas.h"
 #include "KeyboardState.h"
 #include "MouseState.h"
 #include "Rectangle.h"
+#include "DamageRegion.h"
+#include "Compositor.h"
+#include "GlyphCache.h"
+#include "TgaDecoder.h"
+#include "AssetPack.h"
+#include "AssetLoader.h"
+#include "GameTime.h"
 #include "Logger.h"
 
 namespace Constants
@@ -31,6 +49,38 @@ namespace Constants
 
 	/// The default title of the window.
 	static const char* DEFAULT_TITLE = "XLib Window";
+
+	/// Determines if images are placed in MIT-SHM segments when the extension is available.
+	static bool USE_SHM = true;
+
+	/// Determines if only the damaged regions of the back buffer are restored and presented each frame.
+	static bool USE_DAMAGE = true;
+
+	/// Determines if sprites and text are drawn with the XRender extension when the server supports it.
+	static bool USE_XRENDER = true;
+
+	/// Determines if frames are drawn on a render thread while input is read on a connection of its own (see
+	/// Game::run).  Every component must then draw only from the snapshots it publishes.
+	static bool USE_RENDER_THREAD = false;
+
+	/// The asset pack mapped at startup, or NULL to always decode the source assets.
+	static const char* ASSET_PACK = "assets.pack";
+}
+
+namespace Logger
+{
+	/// Display Extension Messages
+	static const char* LOG_SHMENABLED = "# MIT-SHM images enabled";
+	static const char* LOG_SHMDISABLED = "# MIT-SHM unavailable, using XPutImage";
+	static const char* LOG_COMPOSITORENABLED = "# Software compositor enabled, blend kernel: ";
+	static const char* LOG_RENDERENABLED = "# XRender pictures enabled";
+	static const char* LOG_RENDERDISABLED = "# XRender unavailable, drawing with clip masks";
+	static const char* LOG_COMPOSITORDISABLED = "# Software compositor requires a 24 or 32 bit display, disabled";
+	static const char* LOG_PACKMAPPED = "# Asset pack mapped: ";
+	static const char* LOG_PACKFORMAT = "# Asset pack does not match the display pixel format, decoding sources";
+	static const char* LOG_PACKSTALE = "# Asset pack entry is stale, decoding source (rebuild the pack): ";
+	static const char* LOG_EVENTSOPENED = "# Input connection opened, rendering on its own thread";
+	static const char* LOG_EVENTSFAILED = "# Unable to open an input connection, rendering on the game thread";
 }
 
 /// Represents a collection of constants defining XLib colors.
@@ -64,6 +114,31 @@ namespace ColorConstants
 	const unsigned long COLOR_WHITE = 0xFFFFFFL;
 }
 
+/// OverlayCommand
+///	 A text or shape draw recorded by the software compositor and replayed by the server over the uploaded frame.
+struct OverlayCommand
+{
+	enum Type { SET_COLOR, DRAW_RECTANGLE, FILL_RECTANGLE, DRAW_STRING };
+
+	Type type;
+	GC gc;
+	unsigned long colour;
+	int x;
+	int y;
+	unsigned int width;
+	unsigned int height;
+	std::string text;
+};
+
+/// LayerInfo
+///	 The clip mask and size of an off-screen layer (see XInfo::createLayer).
+struct LayerInfo
+{
+	Pixmap mask;
+	int width;
+	int height;
+};
+
 /// XInfo
 ///	 Performs image rendering, creates resources, handles system-level interactions and contains resources.
 class XInfo
@@ -75,10 +150,12 @@ public:
 		border = Constants::DEFAULT_BORDER;
 		input_mask = Constants::DEFAULT_INPUT_MASK;
 		title = Constants::DEFAULT_TITLE;
+		clipMask = None;
+		events = NULL;
 	}
 
 	/// XInfo destructor.
-	~XInfo(void)
+	virtual ~XInfo(void)
 	{
 	}
 
@@ -89,8 +166,14 @@ public:
 	///  @input_mask The events that should the application should be notified of.
 	///  @title The title of the window.
 	///  @icon The filename of the window icon.
-	void initialize(int argc, char* argv[])
+	virtual void initialize(int argc, char* argv[])
 	{
+		// the display is used from the render thread and, while resources are loaded, the game thread
+		if(Constants::USE_RENDER_THREAD)
+		{
+			XInitThreads();
+		}
+
 		// Display opening uses the DISPLAY	environment variable.
 		// It can go wrong if DISPLAY isn't set, or you don't have permission.
 		display = XOpenDisplay("");
@@ -158,101 +241,205 @@ public:
 		XSetFont(display, gtext, font->fid);
 
 		int depth = DefaultDepth(display, DefaultScreen(display));
-		pixmap = XCreatePixmap(display, window, hints.width, hints.height, depth);	
+		pixmap = target = XCreatePixmap(display, window, hints.width, hints.height, depth);	
 		pix_bounds = new Rectangle(0, 0, hints.width, hints.height);
+		backdrop = None;
+		damage.setBounds(hints.width, hints.height);
+		lastDamage.setBounds(hints.width, hints.height);
+		present.setBounds(hints.width, hints.height);
 
 		mouse = new MouseState();
 		keyboard = new KeyboardState();
 
 		XSelectInput(display, window, input_mask);		
+
+		initializeShm();
+		initializeCompositor();
+		initializeRender();
+		initializeAssetPack(ImageByteOrder(display) == LSBFirst && isTrueColorBGR());
 	}
 
-	/// Loads an image from a file path into the specified image pointer.
+	/// Loads a TGA image from a file path into the specified image pointer.  The file is mapped rather than
+	/// read, and the pixels are decoded straight into the image buffer.
 	///  @filename Filename, relative to the loader root directory, and including the extension.
 	///  @img A pointer to the loaded image asset.
 	///  @returns True if successful, false otherwise.
-	/// Notes:
-	///		This method was based the following stackoverflow response to a question regarding loading TGA files.
-	///		METHOD URL: http://stackoverflow.com/a/7050007/2127492
 	bool loadImage(const char* filename, XImage** img)
 	{
-		FILE *filePtr;
-		char ucharBad;
-		short int sintBad;
-		long imageSize;
-		int colorMode;
+		if(loadPackedImage(filename, img, NULL))
+		{
+			return true;
+		}
 
-		unsigned char imageTypeCode;
-		short int imageWidth;
-		short int imageHeight;
-		unsigned char bitCount;
-		char* imageData;
+		// an image prefetched in the background only needs its XImage created here
+		char* pixels;
+		int width, height;
+		if(loader.take(filename, &pixels, &width, &height))
+		{
+			(*img) = createImage(pixels, width, height);
+			return true;
+		}
 
-		// Open the TGA file.
-		filePtr = fopen(filename, "rb");
-		if (filePtr == NULL)
+		TgaDecoder decoder;
+		if(!decoder.open(filename))
 		{
-			return NULL;
+			return false;
+		}
+
+		(*img) = createImage(NULL, decoder.getWidth(), decoder.getHeight());
+		if(!decoder.decode((*img)->data, (*img)->bytes_per_line))
+		{
+			destroyImage(*img);
+			(*img) = NULL;
+			return false;
+		}
+
+		return true;
+	}
+
+	/// Loads an image and derives its clipping mask from the alpha channel.
+	///  @filename Filename of the image, relative to the loader root directory, and including the extension.
+	///  @img A pointer to the loaded image asset.
+	///  @pxm A pointer to the derived clipmap asset.
+	///  @returns True if successful, false otherwise.
+	bool loadImage(const char* filename, XImage** img, Pixmap* pxm)
+	{
+		if(loadPackedImage(filename, img, pxm))
+		{
+			return true;
+		}
+
+		bool readImage = loadImage(filename, img);
+		if(!readImage)
+		{
+			return readImage;
+		}
+
+		(*pxm) = createMask(*img);
+
+		return true;
+	}
+
+	/// Starts decoding an image on the background loader, so a later loadImage of the same file does not block.
+	///  @filename Filename of the image, relative to the loader root directory, and including the extension.
+	void prefetchImage(const char* filename)
+	{
+		// packed images are mapped rather than decoded
+		const AssetPackEntry* entry = assetPack.find(filename);
+		if(entry != NULL && AssetPack::isCurrent(entry))
+		{
+			return;
 		}
+		loader.request(filename);
+	}
 
-		// Read the two first bytes we don't need.
-		fread(&ucharBad, sizeof(char), 1, filePtr);
-		fread(&ucharBad, sizeof(char), 1, filePtr);
+	/// Gets the number of prefetched images still being decoded.
+	///  @returns The number of images the background loader has yet to finish.
+	int getPrefetchCount(void)
+	{
+		return loader.getPendingCount();
+	}
 
-		// Which type of image gets stored in imageTypeCode.
-		fread(&imageTypeCode, sizeof(char), 1, filePtr);
+	/// Creates a 32-bit ZPixmap image over a block of pixel data.
+	///  @data The pixel data, owned by the image after creation, or NULL to allocate uninitialized pixels.
+	///  @width The width of the image.
+	///  @height The height of the image.
+	///  @returns The created image.
+	virtual XImage* createImage(char* data, int width, int height)
+	{
+		if(shmAvailable)
+		{
+			XImage* img = createShmImage(data, width, height);
+			if(img != NULL)
+			{
+				return img;
+			}
+		}
 
-		// For our purposes, the type code should be 2 (uncompressed RGB image)
-		// or 3 (uncompressed black-and-white images).
-		if (imageTypeCode != 2 && imageTypeCode != 3)
+		if(data == NULL)
 		{
-			fclose(filePtr);
-			return false;
+			data = (char*)malloc((size_t)width * height * 4);
 		}
+		return XCreateImage(display, CopyFromParent, depth, ZPixmap, 0, data, width, height, 32, 0);
+	}
 
-		// Read 13 bytes of data we don't need.
-		fread(&sintBad, sizeof(short int), 1, filePtr);
-		fread(&sintBad, sizeof(short int), 1, filePtr);
-		fread(&ucharBad, sizeof(char), 1, filePtr);
-		fread(&sintBad, sizeof(short int), 1, filePtr);
-		fread(&sintBad, sizeof(short int), 1, filePtr);
+	/// Destroys an image, detaching its shared memory segment once the server has finished reading it.
+	///  @img The image to destroy.
+	virtual void destroyImage(XImage* img)
+	{
+		if(img == NULL)
+		{
+			return;
+		}
 
-		// Read the image's width and height.
-		fread(&imageWidth, sizeof(short int), 1, filePtr);
-		fread(&imageHeight, sizeof(short int), 1, filePtr);
+		releasePicture(img);
 
-		// Read the bit depth.
-		fread(&bitCount, sizeof(char), 1, filePtr);
+		std::map<XImage*, Pixmap>::iterator uploaded = serverImages.find(img);
+		if(uploaded != serverImages.end())
+		{
+			XFreePixmap(display, uploaded->second);
+			serverImages.erase(uploaded);
+		}
 
-		// Read one byte of data we don't need.
-		fread(&ucharBad, sizeof(char), 1, filePtr);
+		XShmSegmentInfo* shminfo = getShmInfo(img);
+		if(shminfo == NULL)
+		{
+			// pixels created over the asset pack belong to the mapping
+			if(assetPack.contains(img->data))
+			{
+				img->data = NULL;
+			}
+			XDestroyImage(img);
+			return;
+		}
 
-		// Color mode -> 3 = BGR, 4 = BGRA.
-		colorMode = bitCount / 8;
-		imageSize = imageWidth * imageHeight * colorMode;
+		waitForShmCompletion();
 
-		// Allocate memory for the image data.
-		imageData = (char*)malloc(sizeof(char)*imageSize);
+		XShmDetach(display, shminfo);
+		XSync(display, False);
 
-		// Read the image data.
-		fread(imageData, sizeof(char), imageSize, filePtr);
+		// the pixel data lives in the segment and the segment info is ours, so neither is freed by XDestroyImage
+		img->data = NULL;
+		img->obdata = NULL;
+		XDestroyImage(img);
 
-		char *image32 = (char*)malloc(imageWidth * imageHeight * 4);
-		char *p = image32;
+		shmdt(shminfo->shmaddr);
+		delete shminfo;
+	}
 
-		// Change from BGR to RGB so OpenGL can read the image data.
-		for (int imageIdx = 0; imageIdx < imageSize; imageIdx += colorMode)
+	/// Uploads an image once to a pixmap on the server, so later draws of it are copied on the server instead of
+	/// sending its pixels again.  Meant for images drawn every frame, such as spritesheets, uploaded when they are
+	/// loaded; the pixmap lives until the image is destroyed.  With XRender the image's picture is created instead; the software compositor
+	/// blends from client memory, so nothing is uploaded.
+	///  @img The image to upload.
+	virtual void upload(XImage* img)
+	{
+		if(compositing)
+		{
+			return;
+		}
+		if(renderAvailable)
 		{
-			*(p + 0) = imageData[imageIdx + 0];  // B
-			*(p + 1) = imageData[imageIdx + 1];  // G
-			*(p + 2) = imageData[imageIdx + 2];  // R
-			p = p + 4;
+			getPicture(img);
+			return;
+		}
+		if(serverImages.find(img) != serverImages.end())
+		{
+			return;
 		}
-		fclose(filePtr);
 
-		(*img) = XCreateImage(display, CopyFromParent, depth, ZPixmap, 0, image32, imageWidth, imageHeight, 32, 0);
+		// the pixels are copied whole, so the sprite clip mask must not be set
+		Pixmap pxm = XCreatePixmap(display, window, img->width, img->height, depth);
+		setClipMask(None);
+		uploadImage(pxm, img, 0, 0, 0, 0, img->width, img->height);
+		serverImages[img] = pxm;
+	}
 
-		return true;
+	/// Returns true if images are placed in shared memory segments.
+	///  @returns True if MIT-SHM is in use, false otherwise.
+	bool isShmAvailable(void)
+	{
+		return shmAvailable;
 	}
 
 	/// Loads an image and its associated clipping mask from two file locations.
@@ -269,17 +456,39 @@ public:
 			return readImage;
 		}
 
-		unsigned bw = 0, bh = 0;
-		int hsx = 0, hsy = 0;
-		XReadBitmapFile(display, pixmap, clipFile, &bw, &bh, pxm, &hsx, &hsy);
+		(*pxm) = readPixmap(clipFile);
 
 		return true;
 	}
 
+	/// Creates a clip mask from the alpha channel of an image.
+	///  @img The 32-bit BGRA image.
+	///  @returns The created mask bitmap.
+	virtual Pixmap createMask(XImage* img)
+	{
+		int maskStride = (img->width + 7) / 8;
+		unsigned char* bits = (unsigned char*)malloc((size_t)maskStride * img->height);
+		TgaDecoder::getAlphaMask(img->data, img->bytes_per_line, img->width, img->height, bits);
+
+		Pixmap mask = createBitmap((const char*)bits, img->width, img->height);
+		free(bits);
+		return mask;
+	}
+
+	/// Creates a 1-bit pixmap from rows of bits in XBM layout.
+	///  @bits The bitmap rows, (width + 7) / 8 bytes each, least significant bit first.
+	///  @width The width of the bitmap.
+	///  @height The height of the bitmap.
+	///  @returns The created bitmap.
+	virtual Pixmap createBitmap(const char* bits, int width, int height)
+	{
+		return XCreateBitmapFromData(display, window, bits, width, height);
+	}
+
 	/// Loads a pixmap from a file path into the specified pixmap pointer.
 	///  @filename Filename, relative to the loader root directory, and including the extension.
 	///  @returns The loaded pixmap asset.
-	Pixmap readPixmap(const char* filename)
+	virtual Pixmap readPixmap(const char* filename)
 	{
 		unsigned bw = 0, bh = 0;
 		int hsx = 0, hsy = 0;
@@ -298,20 +507,35 @@ public:
 	///  @height The height of the image to draw.
 	///  @img A pointer to the image asset to be drawn.
 	///  @mask A pointer to the clipmask of the image.
-	void draw(int x, int y,	int posx, int posy,	int width, int height, XImage* img, Pixmap mask)
+	virtual void draw(int x, int y,	int posx, int posy,	int width, int height, XImage* img, Pixmap mask)
 	{
+		if(compositing)
+		{
+			targetSurface->blend(img, posx, posy, width, height, x, y);
+			addDamage(x, y, width, height);
+			return;
+		}
+
+		if(renderAvailable)
+		{
+			composite(img, posx, posy, width, height, x, y);
+			markLayer(mask, posx, posy, width, height, x, y);
+			return;
+		}
+
 		int srcx = x - posx;
 		int srcy = y - posy;
 
-		XSetClipMask(display, gdraw, mask);
-		XSetClipOrigin(display, gdraw, srcx, srcy);		
+		setClipMask(mask);
+		if(mask != None)
+		{
+			XSetClipOrigin(display, gdraw, srcx, srcy);
+		}
 
-		XPutImage(display, pixmap, gdraw, img,
-			posx, posy,
-			x, y,
-			width, height);
+		putImage(img, posx, posy, x, y, width, height);
+		markLayer(mask, posx, posy, width, height, x, y);
 
-		XSetClipMask(display, gdraw, None);
+		setClipMask(None);
 	}
 
 	/// Draws an image from a spritesheet.
@@ -319,22 +543,74 @@ public:
 	///  @x The x-coordinate (in screen coordinates) to draw the image.
 	///  @y The y-coordinate (in screen coordinates) to draw the image.
 	///  @index The index of the image to be drawn.
-	void draw(Spritesheet* sheet, int x, int y, int index)
+	virtual void draw(Spritesheet* sheet, int x, int y, int index)
 	{
-		int srcx, srcy, posx, posy;
+		int srcx, srcy, posx = 0, posy = 0;
 
 		sheet->getInfo(index, &posx, &posy);
 
+		if(compositing)
+		{
+			targetSurface->blend(sheet->getImage(), posx, posy, sheet->getSpriteWidth(), sheet->getSpriteHeight(), x, y);
+			addDamage(x, y, sheet->getSpriteWidth(), sheet->getSpriteHeight());
+			return;
+		}
+
+		if(renderAvailable)
+		{
+			composite(sheet->getImage(), posx, posy, sheet->getSpriteWidth(), sheet->getSpriteHeight(), x, y);
+			markLayer(spriteMask, posx, posy, sheet->getSpriteWidth(), sheet->getSpriteHeight(), x, y);
+			return;
+		}
+
 		srcx = x - posx;
 		srcy = y - posy;
 
-		XSetClipOrigin(display, gdraw, srcx, srcy);
+		// the clip origin only matters while a mask is set
+		if(clipMask != None)
+		{
+			XSetClipOrigin(display, gdraw, srcx, srcy);
+		}
+
+		putImage(sheet->getImage(), posx, posy, x, y, sheet->getSpriteWidth(), sheet->getSpriteHeight());
+		markLayer(spriteMask, posx, posy, sheet->getSpriteWidth(), sheet->getSpriteHeight(), x, y);
+	}
+
+	/// Draws an image from a texture atlas.
+	///  @atlas The texture atlas to draw the image from.
+	///  @x The x-coordinate (in screen coordinates) to draw the image.
+	///  @y The y-coordinate (in screen coordinates) to draw the image.
+	///  @id The id of the image to be drawn, as resolved by TextureAtlas::getId.
+	virtual void draw(TextureAtlas* atlas, int x, int y, int id)
+	{
+		if(id < 0 || id >= atlas->getCount())
+			return;
+
+		const AtlasRegion& region = atlas->getRegion(id);
+		if(region.width == 0)
+			return;
+
+		if(compositing)
+		{
+			targetSurface->blend(atlas->getImage(), region.x, region.y, region.width, region.height, x, y);
+			addDamage(x, y, region.width, region.height);
+			return;
+		}
+
+		if(renderAvailable)
+		{
+			composite(atlas->getImage(), region.x, region.y, region.width, region.height, x, y);
+			markLayer(spriteMask, region.x, region.y, region.width, region.height, x, y);
+			return;
+		}
+
+		if(clipMask != None)
+		{
+			XSetClipOrigin(display, gdraw, x - region.x, y - region.y);
+		}
 
-		XPutImage(display, pixmap, gdraw, sheet->getImage(),
-			posx, posy,
-			x, y,
-			sheet->getSpriteWidth(),
-			sheet->getSpriteHeight());
+		putImage(atlas->getImage(), region.x, region.y, x, y, region.width, region.height);
+		markLayer(spriteMask, region.x, region.y, region.width, region.height, x, y);
 	}
 
 	/// Adds a string to a batch of sprites for rendering using the specified font, text, position, and color.
@@ -342,23 +618,34 @@ public:
 	///  @x The x-coordinate (in screen coordinates) to draw the image.
 	///  @y The y-coordinate (in screen coordinates) to draw the image.
 	///  @colour The color to tint a string.
-	void drawString(std::string str, int x, int y, unsigned long colour)
+	virtual void drawString(const char* text, int x, int y, unsigned long colour)
 	{
-		const char* text = str.c_str();
-		int length = str.length();
-		GC gc_text = getTextDevice();
-
-		XSetForeground(display, gc_text, 0UL);
-		for(int rx = -1; rx <= 1; rx++)
+		int length = strlen(text);
+		if(compositing)
 		{
-			for(int ry = -1; ry <= 1; ry++)
+			addOverlay(OverlayCommand::DRAW_STRING, NULL, colour, x, y, 0, 0, text);
+		}
+		else
+		{
+			renderString(target, text, length, x, y, colour);
+			if(targetMask != None)
 			{
-				XDrawString(display, pixmap, gc_text, x - rx, y - ry, text, length);
+				renderMaskString(text, length, x, y);
 			}
 		}
 
-		XSetForeground(display, gc_text, colour);
-		XDrawString(display, pixmap, gc_text, x, y,	text, length);
+		// the outline extends the text by a pixel on every side
+		addDamage(x - 1, y - font->ascent - 1, XTextWidth(font, text, length) + 2, font->ascent + font->descent + 2);
+	}
+
+	/// Adds a string to a batch of sprites for rendering using the specified font, text, position, and color.
+	///  @str A text string.
+	///  @x The x-coordinate (in screen coordinates) to draw the image.
+	///  @y The y-coordinate (in screen coordinates) to draw the image.
+	///  @colour The color to tint a string.
+	void drawString(const std::string& str, int x, int y, unsigned long colour)
+	{
+		drawString(str.c_str(), x, y, colour);
 	}
 
 	/// Draws a rectangle outline to the screen.
@@ -367,9 +654,21 @@ public:
 	///  @y The y-coordinate of the rectangle.
 	///  @width The width of the rectangle.
 	///  @height The height of the rectangle. 
-	void drawRectangle(GC gc, int x, int y, unsigned int width, unsigned int height)
+	virtual void drawRectangle(GC gc, int x, int y, unsigned int width, unsigned int height)
 	{
-		XDrawRectangle(display, pixmap, gc, x, y, width, height);
+		if(compositing)
+		{
+			addOverlay(OverlayCommand::DRAW_RECTANGLE, gc, 0, x, y, width, height, std::string());
+		}
+		else
+		{
+			XDrawRectangle(display, target, gc, x, y, width, height);
+			if(targetMask != None)
+			{
+				XDrawRectangle(display, targetMask, maskContext, x, y, width, height);
+			}
+		}
+		addDamage(x, y, width + 1, height + 1);
 	}
 
 	/// Draws a rectangle to the screen.
@@ -378,114 +677,536 @@ public:
 	///  @y The y-coordinate of the rectangle.
 	///  @width The width of the rectangle.
 	///  @height The height of the rectangle. 
-	void fillRectangle(GC gc, int x, int y, unsigned int width, unsigned int height)
+	virtual void fillRectangle(GC gc, int x, int y, unsigned int width, unsigned int height)
 	{
-		XFillRectangle(display, pixmap, gc, x, y, width, height);
+		if(compositing)
+		{
+			addOverlay(OverlayCommand::FILL_RECTANGLE, gc, 0, x, y, width, height, std::string());
+		}
+		else
+		{
+			XFillRectangle(display, target, gc, x, y, width, height);
+			if(targetMask != None)
+			{
+				XFillRectangle(display, targetMask, maskContext, x, y, width, height);
+			}
+		}
+		addDamage(x, y, width, height);
 	}
 
 	/// Sets the draw color of the graphic context.
 	///  @gc The graphic context to be used when drawing.
 	///  @value The color value to specify.
-	void setColor(GC gc, const unsigned long value)
+	virtual void setColor(GC gc, const unsigned long value)
 	{
+		if(compositing)
+		{
+			addOverlay(OverlayCommand::SET_COLOR, gc, value, 0, 0, 0, 0, std::string());
+			return;
+		}
 		XSetForeground(display, gc, value); 
 	}
 
 	/// Sets the clip mask of the sprite graphics context.
 	///  @img_mask Specifies the pixmap of the graphics device.
-	void setMask(Pixmap img_mask)
+	virtual void setMask(Pixmap img_mask)
 	{
-		XSetClipMask(display, gdraw, img_mask);
+		// the compositor and XRender use the image alpha instead of clip masks, though layers still need the mask
+		spriteMask = img_mask;
+		if(compositing || renderAvailable)
+		{
+			return;
+		}
+		setClipMask(img_mask);
 	}
 
 	/// Clears the clip mask of the sprite graphics context.
-	void clearMask(void)
+	virtual void clearMask(void)
 	{
-		XSetClipMask(display, gdraw, None);
+		spriteMask = None;
+		if(compositing || renderAvailable)
+		{
+			return;
+		}
+		setClipMask(None);
 	}
 
-	/// Clears image resource buffers.
-	void clear(void)
+	/// Clears image resource buffers.  The back buffer is restored from the backdrop (or filled when there is none),
+	/// and with damage tracking only where the previous frame drew.
+	virtual void clear(void)
 	{
-		XFillRectangle(display, pixmap, gdraw, 0, 0, getImageWidth(), getImageHeight());
+		// the server may still be reading the previous frame out of shared memory
+		if(compositing)
+		{
+			waitForShmCompletion();
+		}
+
+		lastDamage.clear();
+		lastDamage.add(damage);
+		damage.clear();
+
+		if(!Constants::USE_DAMAGE)
+		{
+			lastDamage.addAll();
+		}
+		lastDamage.merge();
+
+		std::vector<XRectangle>& rects = lastDamage.getRectangles();
+		for(size_t i = 0; i < rects.size(); i++)
+		{
+			XRectangle& rect = rects[i];
+			if(compositing)
+			{
+				if(backdropSurface != NULL)
+				{
+					framebuffer->copy(backdropSurface, rect.x, rect.y, rect.width, rect.height, rect.x, rect.y);
+				}
+				else
+				{
+					framebuffer->fill(rect.x, rect.y, rect.width, rect.height, 0xFF000000);
+				}
+			}
+			else if(backdrop != None)
+			{
+				XCopyArea(display, backdrop, pixmap, gdraw, rect.x, rect.y, rect.width, rect.height, rect.x, rect.y);
+			}
+			else
+			{
+				XFillRectangle(display, pixmap, gdraw, rect.x, rect.y, rect.width, rect.height);
+			}
+		}
 	}
 
 	/// Presents the display with the contents of the buffer in the sequence of back buffers owned by the XInfo.
-	void flush(void)
+	/// With damage tracking only the regions drawn this frame or restored from the previous frame are copied.
+	virtual void flush(void)
 	{
-		XCopyArea(display, pixmap, window, gdraw,	0, 0, getImageWidth(), getImageHeight(), pix_bounds->getLeft(), pix_bounds->getTop());
+		present.clear();
+		present.add(lastDamage);
+		present.add(damage);
+		if(!Constants::USE_DAMAGE)
+		{
+			present.addAll();
+		}
+		present.merge();
+
+		if(compositing)
+		{
+			presentFrame();
+		}
+
+		int left = pix_bounds->getLeft();
+		int top = pix_bounds->getTop();
+
+		std::vector<XRectangle>& rects = present.getRectangles();
+		for(size_t i = 0; i < rects.size(); i++)
+		{
+			XRectangle& rect = rects[i];
+			XCopyArea(display, pixmap, window, gdraw, rect.x, rect.y, rect.width, rect.height, left + rect.x, top + rect.y);
+		}
+
+		// what was presented is now on screen, so it only needs restoring on the next clear
+		lastDamage.clear();
 
 		XFlush(display);
 	}
 
+	/// Sets the pixmap the back buffer is restored from when cleared, or None to fill it.
+	///  @pxm The backdrop pixmap, the size of the back buffer.
+	void setBackdrop(Pixmap pxm)
+	{
+		backdrop = pxm;
+		backdropSurface = findSurface(pxm);
+		damage.addAll();
+	}
+
+	/// Marks a region of the back buffer as changed, so it is presented and later restored.
+	///  @x The x-coordinate of the region.
+	///  @y The y-coordinate of the region.
+	///  @width The width of the region.
+	///  @height The height of the region.
+	void addDamage(int x, int y, int width, int height)
+	{
+		if(target == pixmap)
+		{
+			damage.add(x, y, width, height);
+		}
+	}
+
+	/// Marks the whole back buffer as changed.
+	void addDamage(void)
+	{
+		damage.addAll();
+	}
+
+	/// Gets the area of the back buffer presented by the last flush.
+	///  @returns The presented area in pixels.
+	long getPresentedArea(void)
+	{
+		return present.getArea();
+	}
+
 	/// Opens the window.
-	void openw(void)
+	virtual void openw(void)
 	{
 		XMapRaised(display, window);		
 		XFlush(display);
+		damage.addAll();
 
 		// let server get set up before sending drawing commands
 		wait(2);	
 	}
 
 	/// Closes the current window and display.
-	void close(void)
+	virtual void close(void)
 	{
+		releaseCompositor();
+		releaseRender();
+		for(std::map<XImage*, Pixmap>::iterator it = serverImages.begin(); it != serverImages.end(); ++it)
+		{
+			XFreePixmap(display, it->second);
+		}
+		serverImages.clear();
+		if(events != NULL)
+		{
+			XCloseDisplay(events);
+			events = NULL;
+		}
 		XCloseDisplay(display);
 	}
 
-	/// Sleeps the game for a period of milliseconds.
-	///  @time The number of milliseconds to sleep the game.
-	void wait(long time)
+	/// Opens a second connection that input is read from, leaving the display connection to the render thread, so
+	/// reading input never waits behind the requests of a frame.  The window's connection keeps only the events
+	/// drawing needs (resizes and shared memory completions, see handleRenderEvents).
+	///  @returns True if the connection was opened; false to read input on the display connection.
+	virtual bool openEventConnection(void)
 	{
-		usleep(time);
-	}
+		events = XOpenDisplay("");
+		if(events == NULL)
+		{
+			Logger::application_debug(Logger::LOG_EVENTSFAILED);
+			return false;
+		}
 
-	/// Returns the window size hints.
-	///  @returns The window size hints.
-	XSizeHints getWindowHints(void)
-	{
-		return hints;
+		// button presses can only be selected by one client, so the display connection gives them up first
+		XSelectInput(display, window, StructureNotifyMask);
+		XSync(display, False);
+		XSelectInput(events, window, input_mask & ~StructureNotifyMask);
+		XFlush(events);
+
+		Logger::application_debug(Logger::LOG_EVENTSOPENED);
+		return true;
 	}
 
-	/// Returns the current Keyboard state.
-	///  @returns The current keyboard state. 
-	KeyboardState* getKeyboardState(void)
+	/// Processes all pending input events, updating the keyboard and mouse.  Without an input connection the
+	/// window events of the display connection are processed too.
+	virtual void handleEvents(void)
 	{
-		return keyboard;
+		Display* source = events != NULL ? events : display;
+		XEvent event;
+
+		// Although this could possibly block (unending event list) it is
+		// unlikely and more of a stress case than a real world scenario
+		// At least for the purposes of this assignment
+		while(XPending(source) > 0)
+		{
+			XNextEvent(source, &event);
+			handleEvent(&event);
+		}
 	}
 
-	/// Returns the current Mouse state.
-	///  @returns The current mouse state. 
-	MouseState* getMouseState(void)
+	/// Processes the window resizes and shared memory completions of the display connection, on the render
+	/// thread.  Does nothing without an input connection, as handleEvents processes them.
+	virtual void handleRenderEvents(void)
 	{
-		return mouse;
+		if(events == NULL)
+		{
+			return;
+		}
+
+		XEvent event;
+		while(XPending(display) > 0)
+		{
+			XNextEvent(display, &event);
+
+			// input selected before the input connection opened belongs to the game thread, so it is dropped
+			if(event.type == ConfigureNotify || (shmAvailable && event.type == shmCompletionType))
+			{
+				handleEvent(&event);
+			}
+		}
 	}
 
-	/// Gets the current display device.
-	///  @returns The current display device.
-	Display* getDisplay(void)
+	/// Releases a pixmap created by the display.
+	///  @pxm The pixmap to release.
+	virtual void freePixmap(Pixmap pxm)
 	{
-		return display;
+		releaseTargetPicture(pxm);
+
+		std::map<Pixmap, LayerInfo>::iterator layer = layers.find(pxm);
+		if(layer != layers.end())
+		{
+			XFreePixmap(display, layer->second.mask);
+			layers.erase(layer);
+		}
+
+		if(!releaseSurface(pxm))
+		{
+			XFreePixmap(display, pxm);
+		}
 	}
 
-	/// Gets the underlying operating system window.
-	///  @returns The application window.
-	Window getWindow(void)
+	/// Creates an off-screen pixmap with the depth of the display.
+	///  @width The width of the pixmap.
+	///  @height The height of the pixmap.
+	///  @returns The created pixmap.
+	virtual Pixmap createPixmap(int width, int height)
 	{
-		return window;
+		if(compositing)
+		{
+			return createSurface(width, height);
+		}
+		return XCreatePixmap(display, window, width, height, depth);
 	}
 
-	/// Gets the screen number for the application.
-	///  @returns The screen number.
-	int getScreen(void)
+	/// Copies a region of a pixmap to the render target.  The sprite clip mask must be cleared.
+	///  @src The pixmap to copy from.
+	///  @srcx The x-coordinate (in pixmap coordinates) of the region.
+	///  @srcy The y-coordinate (in pixmap coordinates) of the region.
+	///  @width The width of the region.
+	///  @height The height of the region.
+	///  @x The x-coordinate (in screen coordinates) to copy the region to.
+	///  @y The y-coordinate (in screen coordinates) to copy the region to.
+	virtual void copyArea(Pixmap src, int srcx, int srcy, int width, int height, int x, int y)
 	{
-		return screen;
+		if(compositing)
+		{
+			Surface* surface = findSurface(src);
+			if(surface != NULL)
+			{
+				targetSurface->copy(surface, srcx, srcy, width, height, x, y);
+			}
+		}
+		else
+		{
+			XCopyArea(display, src, target, gdraw, srcx, srcy, width, height, x, y);
+		}
+		addDamage(x, y, width, height);
+	}
+
+	/// Creates an off-screen layer: a pixmap with a clip mask of what has been drawn to it, so its contents can be
+	/// drawn over the frame with one masked copy (see drawLayer).  While the layer is the render target, sprites,
+	/// strings, rectangles and fills also mark the mask.  The software compositor draws text over the uploaded frame,
+	/// so it has no layers.
+	///  @width The width of the layer.
+	///  @height The height of the layer.
+	///  @returns The pixmap of the layer, or None if layers are unavailable.
+	virtual Pixmap createLayer(int width, int height)
+	{
+		if(compositing)
+		{
+			return None;
+		}
+
+		LayerInfo info;
+		info.mask = XCreatePixmap(display, window, width, height, 1);
+		info.width = width;
+		info.height = height;
+		if(maskContext == NULL)
+		{
+			maskContext = XCreateGC(display, info.mask, 0, NULL);
+			XSetFont(display, maskContext, font->fid);
+		}
+
+		Pixmap pxm = XCreatePixmap(display, window, width, height, depth);
+		layers[pxm] = info;
+		clearLayer(pxm);
+		return pxm;
+	}
+
+	/// Clears the mask of a layer, so nothing of it is drawn until it is drawn to again.
+	///  @layer The layer to clear.
+	void clearLayer(Pixmap layer)
+	{
+		std::map<Pixmap, LayerInfo>::iterator it = layers.find(layer);
+		if(it != layers.end())
+		{
+			clearLayer(layer, 0, 0, it->second.width, it->second.height);
+		}
+	}
+
+	/// Clears the mask of a region of a layer, so nothing of the region is drawn until it is drawn to again.
+	///  @layer The layer to clear.
+	///  @x The x-coordinate (in layer coordinates) of the region.
+	///  @y The y-coordinate (in layer coordinates) of the region.
+	///  @width The width of the region.
+	///  @height The height of the region.
+	virtual void clearLayer(Pixmap layer, int x, int y, int width, int height)
+	{
+		std::map<Pixmap, LayerInfo>::iterator it = layers.find(layer);
+		if(it == layers.end())
+		{
+			return;
+		}
+
+		int right = std::min(it->second.width, x + width);
+		int bottom = std::min(it->second.height, y + height);
+		x = std::max(0, x);
+		y = std::max(0, y);
+		if(right <= x || bottom <= y)
+		{
+			return;
+		}
+
+		XSetForeground(display, maskContext, 0);
+		XFillRectangle(display, it->second.mask, maskContext, x, y, right - x, bottom - y);
+		XSetForeground(display, maskContext, 1);
+	}
+
+	/// Moves what has been drawn to a layer, mask included, by an offset.  The region uncovered is cleared, so only
+	/// it needs drawing again.  The sprite clip mask must be cleared.
+	///  @layer The layer to scroll.
+	///  @dx The distance to move the contents right (or left, when negative).
+	///  @dy The distance to move the contents down (or up, when negative).
+	virtual void scrollLayer(Pixmap layer, int dx, int dy)
+	{
+		std::map<Pixmap, LayerInfo>::iterator it = layers.find(layer);
+		if(it == layers.end())
+		{
+			return;
+		}
+
+		int width = it->second.width - std::abs(dx);
+		int height = it->second.height - std::abs(dy);
+		if(width <= 0 || height <= 0)
+		{
+			clearLayer(layer);
+			return;
+		}
+
+		int srcx = std::max(0, -dx);
+		int srcy = std::max(0, -dy);
+		XCopyArea(display, layer, layer, gdraw, srcx, srcy, width, height, srcx + dx, srcy + dy);
+		XCopyArea(display, it->second.mask, it->second.mask, maskContext, srcx, srcy, width, height, srcx + dx, srcy + dy);
+
+		// the columns and rows the contents moved away from
+		clearLayer(layer, dx > 0 ? 0 : width, 0, std::abs(dx), it->second.height);
+		clearLayer(layer, 0, dy > 0 ? 0 : height, it->second.width, std::abs(dy));
+	}
+
+	/// Draws what has been drawn to a layer over the render target, with one copy through the layer's mask.
+	///  @layer The layer to draw.
+	///  @x The x-coordinate (in screen coordinates) to draw the layer.
+	///  @y The y-coordinate (in screen coordinates) to draw the layer.
+	virtual void drawLayer(Pixmap layer, int x, int y)
+	{
+		std::map<Pixmap, LayerInfo>::iterator it = layers.find(layer);
+		if(it == layers.end())
+		{
+			return;
+		}
+
+		setClipMask(it->second.mask);
+		XSetClipOrigin(display, gdraw, x, y);
+		XCopyArea(display, layer, target, gdraw, 0, 0, it->second.width, it->second.height, x, y);
+		setClipMask(None);
+		addDamage(x, y, it->second.width, it->second.height);
+	}
+
+	/// Redirects drawing to an off-screen pixmap instead of the back buffer.
+	///  @pxm The pixmap to draw to.
+	void setRenderTarget(Pixmap pxm)
+	{
+		target = pxm;
+
+		std::map<Pixmap, LayerInfo>::iterator layer = layers.find(pxm);
+		targetMask = layer != layers.end() ? layer->second.mask : None;
+
+		Surface* surface = findSurface(pxm);
+		targetSurface = surface != NULL ? surface : framebuffer;
+	}
+
+	/// Restores drawing to the back buffer.
+	void resetRenderTarget(void)
+	{
+		target = pixmap;
+		targetMask = None;
+		targetSurface = framebuffer;
+	}
+
+	/// Returns true if sprites are blended into the client-side framebuffer.
+	///  @returns True if the software compositor is in use, false otherwise.
+	bool isCompositing(void)
+	{
+		return compositing;
+	}
+
+	/// Returns true if sprites and text are drawn with XRender.
+	///  @returns True if the XRender backend is in use, false otherwise.
+	bool isRenderAvailable(void)
+	{
+		return renderAvailable;
+	}
+
+	/// Sleeps the game for a period of microseconds.
+	///  @time The number of microseconds to sleep the game.
+	virtual void wait(long time)
+	{
+		usleep(time);
+	}
+
+	/// Gets the current time of the platform clock.
+	///  @returns The monotonic time in nanoseconds.
+	virtual unsigned long getNow(void)
+	{
+		return GameTime::getNow();
+	}
+
+	/// Returns the window size hints.
+	///  @returns The window size hints.
+	XSizeHints getWindowHints(void)
+	{
+		return hints;
+	}
+
+	/// Returns the current Keyboard state.
+	///  @returns The current keyboard state. 
+	KeyboardState* getKeyboardState(void)
+	{
+		return keyboard;
+	}
+
+	/// Returns the current Mouse state.
+	///  @returns The current mouse state. 
+	MouseState* getMouseState(void)
+	{
+		return mouse;
+	}
+
+	/// Gets the current display device.
+	///  @returns The current display device.
+	Display* getDisplay(void)
+	{
+		return display;
+	}
+
+	/// Gets the underlying operating system window.
+	///  @returns The application window.
+	Window getWindow(void)
+	{
+		return window;
+	}
+
+	/// Gets the screen number for the application.
+	///  @returns The screen number.
+	int getScreen(void)
+	{
+		return screen;
 	}
 
 	/// Creates a graphic context from the current display.
 	///  @returns A newly created graphic context.
-	GC createGraphicContext(void)
+	virtual GC createGraphicContext(void)
 	{
 		return XCreateGC(display, window, 0, 0);
 	}
@@ -558,10 +1279,13 @@ public:
 		title = wtitle;
 	}
 
-private:
+protected:
 	/// XLib variables
 	Display *display;
 	Window window;
+
+	/// The connection input is read from when rendering has a thread of its own, or NULL
+	Display* events;
 	XSizeHints hints;
 	int windowWidth, windowHeight;
 
@@ -575,16 +1299,825 @@ private:
 	unsigned int depth;
 
 	Pixmap pixmap;
+	Pixmap target;
+	Pixmap backdrop;
 	Rectangle* pix_bounds;
 
+	/// The clip mask set on the sprite graphics context, so unchanged masks are not sent again
+	Pixmap clipMask;
+
+	/// Regions of the back buffer drawn this frame, left over from the previous frame, and presented
+	DamageRegion damage;
+	DamageRegion lastDamage;
+	DamageRegion present;
+
 	/// Input state managements
 	KeyboardState* keyboard;
 	MouseState* mouse;
 
 	int border;
 	unsigned int input_mask;
+	int inside = 0;
+
+	/// Shared memory image state
+	bool shmAvailable = false;
+	int shmCompletionType = 0;
+	long pendingShmPuts = 0;
+
+	/// Off-screen layers and their masks; the mask of the render target when it is a layer
+	std::map<Pixmap, LayerInfo> layers;
+	Pixmap targetMask = None;
+	GC maskContext = NULL;
+
+	/// The mask of the sprites being drawn, kept even where the image alpha is used, so layers can be marked
+	Pixmap spriteMask = None;
+
+	/// Pixmaps images were uploaded to, which draws copy from instead of sending the pixels
+	std::map<XImage*, Pixmap> serverImages;
+
+	/// Software compositor state; off-screen pixmaps are client-side surfaces while compositing
+	bool compositing = false;
+	XImage* frameImage = NULL;
+	Surface* framebuffer = NULL;
+	Surface* targetSurface = NULL;
+	Surface* backdropSurface = NULL;
+	std::map<Pixmap, Surface*> surfaces;
+	Pixmap nextSurface = SURFACE_ID_BASE;
+	std::vector<OverlayCommand> overlay;
+
+	/// XRender state; images are uploaded once as premultiplied pictures, and render targets get pictures as drawn to
+	bool renderAvailable = false;
+	XRenderPictFormat* argbFormat = NULL;
+	XRenderPictFormat* targetFormat = NULL;
+	XRenderPictFormat* glyphFormat = NULL;
+	GC argbContext = NULL;
+	std::map<XImage*, Picture> pictures;
+	std::map<Drawable, Picture> targetPictures;
+	std::map<unsigned long, Picture> fills;
+	GlyphCache glyphs;
+
+	/// Packed images, created over the mapped archive when they match the display and their source
+	AssetPack assetPack;
+
+	/// Images being decoded in the background, claimed by loadImage
+	AssetLoader loader;
+
+	/// Maps the asset pack, if one was built and its pixels can be uploaded to the display unchanged.
+	///  @compatible True if the display takes 32-bit BGRA ZPixmap images.
+	void initializeAssetPack(bool compatible)
+	{
+		if(Constants::ASSET_PACK == NULL || !assetPack.open(Constants::ASSET_PACK))
+		{
+			return;
+		}
+
+		if(!compatible)
+		{
+			assetPack.close();
+			Logger::application_debug(Logger::LOG_PACKFORMAT);
+			return;
+		}
+
+		Logger::application_debug(Logger::LOG_PACKMAPPED, Constants::ASSET_PACK);
+	}
+
+	/// Creates an image (and optionally its clip mask) from the asset pack.
+	///  @filename The source path of the image.
+	///  @img A pointer to the created image.
+	///  @pxm A pointer to the created clip mask, or NULL if no mask is needed.
+	///  @returns True if the pack held a current copy of the image, false otherwise.
+	bool loadPackedImage(const char* filename, XImage** img, Pixmap* pxm)
+	{
+		const AssetPackEntry* entry = assetPack.find(filename);
+		if(entry == NULL)
+		{
+			return false;
+		}
+		if(!AssetPack::isCurrent(entry))
+		{
+			Logger::application_debug(Logger::LOG_PACKSTALE, filename);
+			return false;
+		}
+
+		const char* pixels = assetPack.getPixels(entry);
+		if(shmAvailable)
+		{
+			// the server reads shared images from the segment, so the rows are copied in (no decoding)
+			(*img) = createImage(NULL, entry->width, entry->height);
+			for(uint32_t row = 0; row < entry->height; row++)
+			{
+				memcpy((*img)->data + row * (*img)->bytes_per_line, pixels + row * entry->pixelStride, entry->width * 4);
+			}
+		}
+		else
+		{
+			(*img) = createImage((char*)pixels, entry->width, entry->height);
+		}
+
+		if(pxm != NULL)
+		{
+			(*pxm) = createBitmap(assetPack.getMask(entry), entry->width, entry->height);
+		}
+		return true;
+	}
+
+	/// Creates the client-side framebuffer when the software compositor is requested.
+	void initializeCompositor(void)
+	{
+		compositing = false;
+		if(!Constants::USE_COMPOSITOR)
+		{
+			return;
+		}
+
+		// the framebuffer is uploaded as-is, so the display must use 32 bits per pixel
+		if(depth != 24 && depth != 32)
+		{
+			Logger::application_debug(Logger::LOG_COMPOSITORDISABLED);
+			return;
+		}
+
+		int width = pix_bounds->getWidth();
+		int height = pix_bounds->getHeight();
+
+		frameImage = createImage((char*)calloc(width * height, 4), width, height);
+		framebuffer = new Surface(frameImage);
+		framebuffer->fill(0, 0, width, height, 0xFF000000);
+		targetSurface = framebuffer;
+		backdropSurface = NULL;
+		compositing = true;
+
+		Logger::application_debug(Logger::LOG_COMPOSITORENABLED, Blend::getKernelName());
+	}
+
+	/// Releases the framebuffer and every remaining surface.
+	void releaseCompositor(void)
+	{
+		if(!compositing)
+		{
+			return;
+		}
+
+		for(std::map<Pixmap, Surface*>::iterator it = surfaces.begin(); it != surfaces.end(); ++it)
+		{
+			delete it->second;
+		}
+		surfaces.clear();
+
+		delete framebuffer;
+		destroyImage(frameImage);
+		framebuffer = targetSurface = backdropSurface = NULL;
+		frameImage = NULL;
+		compositing = false;
+	}
+
+	/// Detects the XRender extension and caches the font's glyphs on the server.  Solid fill pictures arrived in
+	/// RENDER 0.10, so older servers keep the clip mask path, as does the software compositor.
+	void initializeRender(void)
+	{
+		renderAvailable = false;
+		if(!Constants::USE_XRENDER || compositing)
+		{
+			return;
+		}
+
+		int eventBase, errorBase;
+		int major = 0, minor = 0;
+		if(!XRenderQueryExtension(display, &eventBase, &errorBase) || !XRenderQueryVersion(display, &major, &minor) || (major == 0 && minor < 10))
+		{
+			Logger::application_debug(Logger::LOG_RENDERDISABLED);
+			return;
+		}
+
+		argbFormat = XRenderFindStandardFormat(display, PictStandardARGB32);
+		glyphFormat = XRenderFindStandardFormat(display, PictStandardA8);
+		targetFormat = XRenderFindVisualFormat(display, DefaultVisual(display, screen));
+		if(argbFormat == NULL || glyphFormat == NULL || targetFormat == NULL || !glyphs.create(display, window, font, glyphFormat))
+		{
+			Logger::application_debug(Logger::LOG_RENDERDISABLED);
+			return;
+		}
+
+		renderAvailable = true;
+		Logger::application_debug(Logger::LOG_RENDERENABLED);
+	}
+
+	/// Releases every picture, fill and cached glyph.
+	void releaseRender(void)
+	{
+		if(!renderAvailable)
+		{
+			return;
+		}
+
+		for(std::map<XImage*, Picture>::iterator it = pictures.begin(); it != pictures.end(); ++it)
+		{
+			XRenderFreePicture(display, it->second);
+		}
+		for(std::map<Drawable, Picture>::iterator it = targetPictures.begin(); it != targetPictures.end(); ++it)
+		{
+			XRenderFreePicture(display, it->second);
+		}
+		for(std::map<unsigned long, Picture>::iterator it = fills.begin(); it != fills.end(); ++it)
+		{
+			XRenderFreePicture(display, it->second);
+		}
+		pictures.clear();
+		targetPictures.clear();
+		fills.clear();
+
+		glyphs.release(display);
+		if(argbContext != NULL)
+		{
+			XFreeGC(display, argbContext);
+			argbContext = NULL;
+		}
+		renderAvailable = false;
+	}
+
+	/// Creates a client-side surface standing in for an off-screen pixmap.
+	///  @width The width of the surface.
+	///  @height The height of the surface.
+	///  @returns The identifier of the surface.
+	Pixmap createSurface(int width, int height)
+	{
+		Pixmap id = nextSurface++;
+		surfaces[id] = new Surface(width, height);
+		return id;
+	}
+
+	/// Releases a client-side surface.
+	///  @pxm The identifier of the surface.
+	///  @returns True if the identifier was a surface, false if it is a server pixmap.
+	bool releaseSurface(Pixmap pxm)
+	{
+		std::map<Pixmap, Surface*>::iterator it = surfaces.find(pxm);
+		if(it == surfaces.end())
+		{
+			return false;
+		}
+
+		if(targetSurface == it->second)
+		{
+			targetSurface = framebuffer;
+		}
+		if(backdropSurface == it->second)
+		{
+			backdropSurface = NULL;
+		}
+
+		delete it->second;
+		surfaces.erase(it);
+		return true;
+	}
+
+	/// Finds the client-side surface of a pixmap identifier.
+	///  @pxm The identifier of the surface.
+	///  @returns The surface, or NULL if the identifier is not a surface.
+	Surface* findSurface(Pixmap pxm)
+	{
+		std::map<Pixmap, Surface*>::iterator it = surfaces.find(pxm);
+		return it != surfaces.end() ? it->second : NULL;
+	}
 
 	// Information
 	const char* title = NULL;
 	const char* icon = NULL;
+
+private:
+	/// Surface identifiers start above the 29-bit range of server resource identifiers.
+	static const Pixmap SURFACE_ID_BASE = 0x40000000;
+
+	/// Records a text or shape draw to be replayed over the uploaded frame.
+	void addOverlay(OverlayCommand::Type type, GC gc, unsigned long colour, int x, int y, unsigned int width, unsigned int height, const std::string& text)
+	{
+		OverlayCommand command;
+		command.type = type;
+		command.gc = gc;
+		command.colour = colour;
+		command.x = x;
+		command.y = y;
+		command.width = width;
+		command.height = height;
+		command.text = text;
+		overlay.push_back(command);
+	}
+
+	/// Uploads the presented region of the framebuffer to the back buffer in a single request, then replays the overlay.
+	void presentFrame(void)
+	{
+		std::vector<XRectangle>& rects = present.getRectangles();
+		if(!rects.empty())
+		{
+			int left = rects[0].x;
+			int top = rects[0].y;
+			int right = rects[0].x + rects[0].width;
+			int bottom = rects[0].y + rects[0].height;
+			for(size_t i = 1; i < rects.size(); i++)
+			{
+				left = std::min(left, (int)rects[i].x);
+				top = std::min(top, (int)rects[i].y);
+				right = std::max(right, rects[i].x + rects[i].width);
+				bottom = std::max(bottom, rects[i].y + rects[i].height);
+			}
+			uploadImage(pixmap, frameImage, left, top, left, top, right - left, bottom - top);
+		}
+
+		for(size_t i = 0; i < overlay.size(); i++)
+		{
+			OverlayCommand& command = overlay[i];
+			switch(command.type)
+			{
+			case OverlayCommand::SET_COLOR:
+				XSetForeground(display, command.gc, command.colour);
+				break;
+			case OverlayCommand::DRAW_RECTANGLE:
+				XDrawRectangle(display, pixmap, command.gc, command.x, command.y, command.width, command.height);
+				break;
+			case OverlayCommand::FILL_RECTANGLE:
+				XFillRectangle(display, pixmap, command.gc, command.x, command.y, command.width, command.height);
+				break;
+			case OverlayCommand::DRAW_STRING:
+				renderString(pixmap, command.text.c_str(), command.text.length(), command.x, command.y, command.colour);
+				break;
+			}
+		}
+		overlay.clear();
+	}
+
+	/// Draws outlined text to a drawable.
+	void renderString(Drawable dst, const char* text, int length, int x, int y, unsigned long colour)
+	{
+		if(renderAvailable)
+		{
+			renderGlyphs(dst, text, length, x, y, colour);
+			return;
+		}
+
+		GC gc_text = getTextDevice();
+
+		XSetForeground(display, gc_text, 0UL);
+		for(int rx = -1; rx <= 1; rx++)
+		{
+			for(int ry = -1; ry <= 1; ry++)
+			{
+				XDrawString(display, dst, gc_text, x - rx, y - ry, text, length);
+			}
+		}
+
+		XSetForeground(display, gc_text, colour);
+		XDrawString(display, dst, gc_text, x, y,	text, length);
+	}
+
+	/// Marks the pixels of a sprite in the mask of the layer being drawn to.
+	void markLayer(Pixmap mask, int srcx, int srcy, int width, int height, int x, int y)
+	{
+		if(targetMask == None)
+		{
+			return;
+		}
+
+		if(mask == None)
+		{
+			XFillRectangle(display, targetMask, maskContext, x, y, width, height);
+			return;
+		}
+
+		// the sprite's pixels are added to those already marked
+		XSetFunction(display, maskContext, GXor);
+		XCopyArea(display, mask, targetMask, maskContext, srcx, srcy, width, height, x, y);
+		XSetFunction(display, maskContext, GXcopy);
+	}
+
+	/// Marks the pixels of outlined text in the mask of the layer being drawn to.
+	void renderMaskString(const char* text, int length, int x, int y)
+	{
+		for(int rx = -1; rx <= 1; rx++)
+		{
+			for(int ry = -1; ry <= 1; ry++)
+			{
+				XDrawString(display, targetMask, maskContext, x - rx, y - ry, text, length);
+			}
+		}
+	}
+
+	/// Draws outlined text to a drawable from the glyph cache.  The eight outline copies are accumulated into one
+	/// glyph mask, so the string costs two composite requests: the outline and the fill.
+	void renderGlyphs(Drawable dst, const char* text, int length, int x, int y, unsigned long colour)
+	{
+		Picture picture = getTargetPicture(dst);
+		int advance = XTextWidth(font, text, length);
+
+		// each element starts where the previous one ended, a string width to the right of where it started
+		XGlyphElt8 outline[8];
+		int count = 0;
+		int penX = 0;
+		int penY = 0;
+		for(int rx = -1; rx <= 1; rx++)
+		{
+			for(int ry = -1; ry <= 1; ry++)
+			{
+				if(rx == 0 && ry == 0)
+				{
+					continue;
+				}
+
+				XGlyphElt8& element = outline[count++];
+				element.glyphset = glyphs.getGlyphSet();
+				element.chars = text;
+				element.nchars = length;
+				element.xOff = x - rx - penX;
+				element.yOff = y - ry - penY;
+				penX = x - rx + advance;
+				penY = y - ry;
+			}
+		}
+		XRenderCompositeText8(display, PictOpOver, getFill(0UL), picture, glyphFormat, 0, 0, 0, 0, outline, count);
+
+		XGlyphElt8 fill;
+		fill.glyphset = glyphs.getGlyphSet();
+		fill.chars = text;
+		fill.nchars = length;
+		fill.xOff = x;
+		fill.yOff = y;
+		XRenderCompositeText8(display, PictOpOver, getFill(colour), picture, glyphFormat, 0, 0, 0, 0, &fill, 1);
+	}
+
+	/// Composites a region of an image over the render target, through the image's picture.
+	void composite(XImage* img, int srcx, int srcy, int width, int height, int x, int y)
+	{
+		XRenderComposite(display, PictOpOver, getPicture(img), None, getTargetPicture(target), srcx, srcy, 0, 0, x, y, width, height);
+		addDamage(x, y, width, height);
+	}
+
+	/// Gets the picture of an image, uploading it the first time the image is drawn.  The pixels are premultiplied
+	/// by their alpha, as XRender expects, into a 32-bit pixmap that stays on the server until the image is destroyed.
+	Picture getPicture(XImage* img)
+	{
+		std::map<XImage*, Picture>::iterator it = pictures.find(img);
+		if(it != pictures.end())
+		{
+			return it->second;
+		}
+
+		int width = img->width;
+		int height = img->height;
+		unsigned char* data = (unsigned char*)malloc((size_t)width * height * 4);
+		for(int y = 0; y < height; y++)
+		{
+			const unsigned char* src = (const unsigned char*)img->data + y * img->bytes_per_line;
+			unsigned char* dst = data + (size_t)y * width * 4;
+			for(int x = 0; x < width * 4; x += 4)
+			{
+				unsigned int alpha = src[x + 3];
+				dst[x] = (src[x] * alpha + 127) / 255;
+				dst[x + 1] = (src[x + 1] * alpha + 127) / 255;
+				dst[x + 2] = (src[x + 2] * alpha + 127) / 255;
+				dst[x + 3] = alpha;
+			}
+		}
+
+		Pixmap pxm = XCreatePixmap(display, window, width, height, 32);
+		if(argbContext == NULL)
+		{
+			argbContext = XCreateGC(display, pxm, 0, NULL);
+		}
+
+		// the rows are BGRA bytes, so the image is little-endian whatever the host
+		XImage* upload = XCreateImage(display, CopyFromParent, 32, ZPixmap, 0, (char*)data, width, height, 32, 0);
+		upload->byte_order = LSBFirst;
+		XPutImage(display, pxm, argbContext, upload, 0, 0, 0, 0, width, height);
+		XDestroyImage(upload);
+
+		// the picture holds the pixmap until the picture is freed
+		Picture picture = XRenderCreatePicture(display, pxm, argbFormat, 0, NULL);
+		XFreePixmap(display, pxm);
+
+		pictures[img] = picture;
+		return picture;
+	}
+
+	/// Releases the picture of an image, if it was uploaded.
+	void releasePicture(XImage* img)
+	{
+		std::map<XImage*, Picture>::iterator it = pictures.find(img);
+		if(it != pictures.end())
+		{
+			XRenderFreePicture(display, it->second);
+			pictures.erase(it);
+		}
+	}
+
+	/// Gets the picture of a drawable that is drawn to, creating it the first time.
+	Picture getTargetPicture(Drawable dst)
+	{
+		std::map<Drawable, Picture>::iterator it = targetPictures.find(dst);
+		if(it != targetPictures.end())
+		{
+			return it->second;
+		}
+
+		Picture picture = XRenderCreatePicture(display, dst, targetFormat, 0, NULL);
+		targetPictures[dst] = picture;
+		return picture;
+	}
+
+	/// Releases the picture of a drawable, if it was drawn to.
+	void releaseTargetPicture(Drawable dst)
+	{
+		std::map<Drawable, Picture>::iterator it = targetPictures.find(dst);
+		if(it != targetPictures.end())
+		{
+			XRenderFreePicture(display, it->second);
+			targetPictures.erase(it);
+		}
+	}
+
+	/// Gets an opaque solid fill picture of a color, creating it the first time.
+	Picture getFill(unsigned long colour)
+	{
+		std::map<unsigned long, Picture>::iterator it = fills.find(colour);
+		if(it != fills.end())
+		{
+			return it->second;
+		}
+
+		XRenderColor value;
+		value.red = ((colour >> 16) & 0xFF) * 257;
+		value.green = ((colour >> 8) & 0xFF) * 257;
+		value.blue = (colour & 0xFF) * 257;
+		value.alpha = 0xFFFF;
+
+		Picture picture = XRenderCreateSolidFill(display, &value);
+		fills[colour] = picture;
+		return picture;
+	}
+
+	/// Returns true if the default visual stores red, green and blue in the bytes the packed BGRA layout uses.
+	bool isTrueColorBGR(void)
+	{
+		Visual* visual = DefaultVisual(display, screen);
+		return (depth == 24 || depth == 32) &&
+			visual->red_mask == 0xFF0000 && visual->green_mask == 0x00FF00 && visual->blue_mask == 0x0000FF;
+	}
+
+	/// Set when the server rejects a shared memory segment.
+	static bool& shmAttachFailed(void)
+	{
+		static bool failed = false;
+		return failed;
+	}
+
+	/// Records a failed shared memory attach instead of terminating the application.
+	static int handleShmError(Display* dpy, XErrorEvent* error)
+	{
+		shmAttachFailed() = true;
+		return 0;
+	}
+
+	/// Detects the MIT-SHM extension.  The server must also be able to attach our segments, which is not
+	/// the case for remote displays, so a probe segment is attached before images are created.
+	void initializeShm(void)
+	{
+		shmAvailable = false;
+		if(!Constants::USE_SHM || !XShmQueryExtension(display))
+		{
+			Logger::application_debug(Logger::LOG_SHMDISABLED);
+			return;
+		}
+
+		shmCompletionType = XShmGetEventBase(display) + ShmCompletion;
+		shmAvailable = true;
+
+		XImage* probe = createShmImage(NULL, 1, 1);
+		if(probe == NULL)
+		{
+			shmAvailable = false;
+			Logger::application_debug(Logger::LOG_SHMDISABLED);
+			return;
+		}
+		destroyImage(probe);
+
+		Logger::application_debug(Logger::LOG_SHMENABLED);
+	}
+
+	/// Creates an image whose pixels live in a shared memory segment attached to the server.
+	///  @data The pixel data to copy into the segment and release, or NULL.
+	///  @width The width of the image.
+	///  @height The height of the image.
+	///  @returns The created image, or NULL if a segment could not be attached.
+	XImage* createShmImage(char* data, int width, int height)
+	{
+		XShmSegmentInfo* shminfo = new XShmSegmentInfo();
+		XImage* img = XShmCreateImage(display, DefaultVisual(display, screen), depth, ZPixmap, NULL, shminfo, width, height);
+		if(img == NULL)
+		{
+			delete shminfo;
+			return NULL;
+		}
+
+		shminfo->shmid = shmget(IPC_PRIVATE, img->bytes_per_line * img->height, IPC_CREAT | 0600);
+		if(shminfo->shmid < 0)
+		{
+			img->obdata = NULL;
+			XDestroyImage(img);
+			delete shminfo;
+			return NULL;
+		}
+
+		void* address = shmat(shminfo->shmid, 0, 0);
+		if(address == (void*)-1)
+		{
+			shmctl(shminfo->shmid, IPC_RMID, 0);
+			img->obdata = NULL;
+			XDestroyImage(img);
+			delete shminfo;
+			return NULL;
+		}
+
+		shminfo->shmaddr = img->data = (char*)address;
+		shminfo->readOnly = True;
+
+		shmAttachFailed() = false;
+		XErrorHandler previous = XSetErrorHandler(handleShmError);
+		XShmAttach(display, shminfo);
+		XSync(display, False);
+		XSetErrorHandler(previous);
+
+		// the segment is released by the system once both sides have detached
+		shmctl(shminfo->shmid, IPC_RMID, 0);
+
+		if(shmAttachFailed())
+		{
+			shmdt(shminfo->shmaddr);
+			img->data = NULL;
+			img->obdata = NULL;
+			XDestroyImage(img);
+			delete shminfo;
+			return NULL;
+		}
+
+		if(data != NULL)
+		{
+			int rowLength = width * 4;
+			for(int y = 0; y < height; y++)
+			{
+				memcpy(img->data + y * img->bytes_per_line, data + y * rowLength, rowLength);
+			}
+			free(data);
+		}
+
+		return img;
+	}
+
+	/// Returns the shared memory segment of an image, or NULL if the image is client-side.
+	///  @img The image to query.
+	XShmSegmentInfo* getShmInfo(XImage* img)
+	{
+		if(!shmAvailable)
+		{
+			return NULL;
+		}
+		return (XShmSegmentInfo*)img->obdata;
+	}
+
+	/// Sets the clip mask of the sprite graphics context, sending a request only if it changes.
+	void setClipMask(Pixmap mask)
+	{
+		if(mask != clipMask)
+		{
+			XSetClipMask(display, gdraw, mask);
+			clipMask = mask;
+		}
+	}
+
+	/// Draws a region of an image to the render target: copied on the server from the pixmap it was uploaded to, or
+	/// otherwise sent through shared memory when possible.
+	void putImage(XImage* img, int srcx, int srcy, int x, int y, int width, int height)
+	{
+		std::map<XImage*, Pixmap>::iterator uploaded = serverImages.find(img);
+		if(uploaded != serverImages.end())
+		{
+			XCopyArea(display, uploaded->second, target, gdraw, srcx, srcy, width, height, x, y);
+		}
+		else
+		{
+			uploadImage(target, img, srcx, srcy, x, y, width, height);
+		}
+		addDamage(x, y, width, height);
+	}
+
+	/// Uploads a region of an image to a drawable, through shared memory when possible.
+	void uploadImage(Drawable dst, XImage* img, int srcx, int srcy, int x, int y, int width, int height)
+	{
+		XShmSegmentInfo* shminfo = getShmInfo(img);
+		if(shminfo != NULL)
+		{
+			XShmPutImage(display, dst, gdraw, img, srcx, srcy, x, y, width, height, True);
+			pendingShmPuts++;
+		}
+		else
+		{
+			XPutImage(display, dst, gdraw, img, srcx, srcy, x, y, width, height);
+		}
+	}
+
+	/// Blocks until the server has reported completion of every shared memory upload.
+	void waitForShmCompletion(void)
+	{
+		if(pendingShmPuts == 0)
+		{
+			return;
+		}
+
+		// once synchronized, every outstanding completion event is in the queue
+		XSync(display, False);
+
+		XEvent event;
+		while(XCheckIfEvent(display, &event, isShmCompletion, (XPointer)this))
+		{
+			pendingShmPuts--;
+		}
+		pendingShmPuts = 0;
+	}
+
+	/// Predicate matching shared memory completion events.
+	static Bool isShmCompletion(Display* dpy, XEvent* event, XPointer arg)
+	{
+		XInfo* xinfo = (XInfo*)arg;
+		return event->type == xinfo->shmCompletionType;
+	}
+
+	/// Dispatches an event to its handler.
+	void handleEvent(XEvent* event)
+	{
+		if(shmAvailable && event->type == shmCompletionType)
+		{
+			pendingShmPuts--;
+			return;
+		}
+
+		switch(event->type)
+		{
+		case KeyRelease:
+			handleKeyRelease(event);
+			break;
+		case KeyPress:
+			handleKeyPress(event);
+			break;
+		case MotionNotify:
+			handleMotion(event);
+			break;
+		case EnterNotify:
+			inside = 1;
+			break;
+		case LeaveNotify:
+			inside = 0;
+			break;
+		case ConfigureNotify:
+			handleResize(event);
+			break;
+		}
+	}
+
+	/// Handles motion events based on mouse input device.
+	void handleMotion(XEvent* event)
+	{
+		if(inside)
+		{
+			mouse->setX(event->xmotion.x);
+			mouse->setY(event->xmotion.y);
+		}
+	}
+
+	/// Handles the window resize event.
+	void handleResize(XEvent* event)
+	{
+		XConfigureEvent xce = event->xconfigure;
+
+		if (xce.width > pix_bounds->getWidth()|| xce.height > pix_bounds->getHeight())
+		{
+			int xDiff = xce.width - pix_bounds->getWidth();
+			int yDiff = xce.height - pix_bounds->getHeight();
+
+			pix_bounds->setPoint(xDiff / 2, yDiff / 2);
+		}
+
+		// the window contents are not retained across a resize
+		damage.addAll();
+	}
+
+	/// Handles a keyboard key press event.
+	void handleKeyPress(XEvent* event)
+	{
+		XKeyEvent* kEvent = (XKeyEvent*)event;
+		keyboard->set((KEYS)kEvent->keycode);
+	}
+
+	/// Handles a keyboard key release event.
+	void handleKeyRelease(XEvent* event)
+	{
+		XKeyEvent* kEvent = (XKeyEvent*)event;
+		keyboard->clear((KEYS)kEvent->keycode);
+	}
 };
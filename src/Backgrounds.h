@@ -0,0 +1,21 @@
+#pragma once
+
+/// Contains the background identifiers, which level files store, so the level tools need not include the game's
+/// settings.
+namespace GameConstants
+{
+	enum BG
+	{
+		/// Background ID for castle.
+		BG_CASTLE = 0,
+
+		/// Background ID for desert.
+		BG_DESERT = 1,
+
+		/// Background ID for grasslands.
+		BG_GRASSLANDS = 2,
+
+		/// Background ID for mushrooms.
+		BG_SHROOM = 3
+	};
+}
@@ -49,13 +49,42 @@ enum BLOCK
 	BLOCK_WATER = 24
 };
 
+/// The properties of a block, as bits of its entry in BLOCKS::BLOCK_FLAGS.
+enum BLOCK_FLAG
+{
+	/// The value names a block.
+	BLOCK_FLAG_VALID = 1 << 0,
+
+	/// The block is solid and collidable.
+	BLOCK_FLAG_SOLID = 1 << 1,
+
+	/// The block can be passed through.
+	BLOCK_FLAG_PASSABLE = 1 << 2,
+
+	/// The block is a platform.
+	BLOCK_FLAG_PLATFORM = 1 << 3,
+
+	/// The block is an objective.
+	BLOCK_FLAG_OBJECTIVE = 1 << 4,
+
+	/// The block stops the player: it is solid, and not an objective to be collected or opened.
+	BLOCK_FLAG_BLOCKING = 1 << 5
+};
+
 namespace BLOCKS
 {
-	/// Returns true if the block value is solid and collidable.
+	/// Works out the flags of a block.  Only used to build BLOCK_FLAGS at compile time.
 	///  @value The value of the block.
-	///  @returns True if the block specified is solid; false otherwise.
-	bool isBlockSolid(int value)
+	///  @returns The BLOCK_FLAG bits of the block.
+	constexpr unsigned char getFlags(int value)
 	{
+		unsigned char flags = 0;
+
+		if(value == BLOCK_EMPTY || (value >= BLOCK_DIRT && value <= BLOCK_WATER))
+		{
+			flags |= BLOCK_FLAG_VALID;
+		}
+
 		switch(value)
 		{
 		case BLOCK_EMPTY:
@@ -69,40 +98,93 @@ namespace BLOCKS
 		case BLOCK_COIN_SILVER:
 		case BLOCK_COIN_SPECIAL:
 		case BLOCK_PLANK:
-			return false;
+			flags |= BLOCK_FLAG_PASSABLE;
+			break;
 		default:
-			return true;
+			flags |= BLOCK_FLAG_SOLID;
+			break;
+		}
+
+		if(value == BLOCK_PLANK)
+		{
+			flags |= BLOCK_FLAG_PLATFORM;
 		}
-	}
 
-	/// Returns true if the block value can be passed through.
-	///  @value The value of the block.
-	///  @returns True if the block specified is not solid; false otherwise.
-	bool isBlockPassable(int value)
-	{
 		switch(value)
 		{
-		case BLOCK_EMPTY:
-		case BLOCK_KEY_BLUE:
-		case BLOCK_KEY_GREEN:
-		case BLOCK_KEY_RED:
-		case BLOCK_KEY_YELLOW:
+		case BLOCK_LOCK_BLUE:
+		case BLOCK_LOCK_GREEN:
+		case BLOCK_LOCK_RED:
+		case BLOCK_LOCK_YELLOW:
 		case BLOCK_COIN_BRONZE:
 		case BLOCK_COIN_GOLD:
 		case BLOCK_COIN_RARE:
 		case BLOCK_COIN_SILVER:
 		case BLOCK_COIN_SPECIAL:
-		case BLOCK_PLANK:
-			return true;
+			flags |= BLOCK_FLAG_OBJECTIVE;
+			break;
 		default:
-			return false;
+			break;
+		}
+
+		if((flags & BLOCK_FLAG_SOLID) && !(flags & BLOCK_FLAG_OBJECTIVE))
+		{
+			flags |= BLOCK_FLAG_BLOCKING;
+		}
+
+		return flags;
+	}
+
+	/// The flags of every block, indexed by the low byte of the block value (so BLOCK_EMPTY is entry 0xFF).
+	struct BlockTable
+	{
+		unsigned char flags[256];
+	};
+
+	/// Builds the block flag table.
+	constexpr BlockTable createFlagTable(void)
+	{
+		BlockTable table = {};
+		for(int i = 0; i < 256; i++)
+		{
+			table.flags[i] = getFlags((signed char)i == BLOCK_EMPTY ? BLOCK_EMPTY : i);
 		}
+		return table;
+	}
+
+	static constexpr BlockTable BLOCK_FLAGS = createFlagTable();
+
+	static_assert(BLOCK_FLAGS.flags[0xFF] == (BLOCK_FLAG_VALID | BLOCK_FLAG_PASSABLE), "BLOCK_EMPTY must be passable");
+	static_assert(BLOCK_FLAGS.flags[BLOCK_LOCK_RED] & BLOCK_FLAG_OBJECTIVE, "locks are objectives");
+
+	/// Gets the flags of a block.
+	///  @value The value of the block.
+	///  @returns The BLOCK_FLAG bits of the block.
+	inline unsigned char getBlockFlags(int value)
+	{
+		return BLOCK_FLAGS.flags[value & 0xFF];
+	}
+
+	/// Returns true if the block value is solid and collidable.
+	///  @value The value of the block.
+	///  @returns True if the block specified is solid; false otherwise.
+	inline bool isBlockSolid(int value)
+	{
+		return getBlockFlags(value) & BLOCK_FLAG_SOLID;
+	}
+
+	/// Returns true if the block value can be passed through.
+	///  @value The value of the block.
+	///  @returns True if the block specified is not solid; false otherwise.
+	inline bool isBlockPassable(int value)
+	{
+		return getBlockFlags(value) & BLOCK_FLAG_PASSABLE;
 	}
 
 	/// Returns true if the block value is impassable.
 	///  @value The value of the block.
 	///  @returns True if the block specified is impassable; false otherwise.
-	bool isBlockImpassable(int value)
+	inline bool isBlockImpassable(int value)
 	{
 		return !isBlockPassable(value);
 	}	
@@ -110,30 +192,24 @@ namespace BLOCKS
 	/// Returns true if the block value is a platform.
 	///  @value The value of the block.
 	///  @returns True if the block specified is a platform; false otherwise.
-	bool isBlockPlatform(int value)
+	inline bool isBlockPlatform(int value)
+	{
+		return getBlockFlags(value) & BLOCK_FLAG_PLATFORM;
+	}
+
+	/// Returns true if the value is one of the defined blocks.
+	///  @value The value of the block.
+	///  @returns True if the value names a block, false otherwise.
+	inline bool isBlockValid(int value)
 	{
-		return BLOCK_PLANK == value;
+		return value >= BLOCK_EMPTY && value <= BLOCK_WATER && (getBlockFlags(value) & BLOCK_FLAG_VALID);
 	}
 
 	/// Returns true if the block is an objective.
 	///  @value The value of the block.
 	///  @returns True if an objective, false otherwise
-	bool isBlockObjective(int value)
+	inline bool isBlockObjective(int value)
 	{
-		switch(value)
-		{
-		case BLOCK_LOCK_BLUE:
-		case BLOCK_LOCK_GREEN:
-		case BLOCK_LOCK_RED:
-		case BLOCK_LOCK_YELLOW:
-		case BLOCK_COIN_BRONZE:
-		case BLOCK_COIN_GOLD:
-		case BLOCK_COIN_RARE:
-		case BLOCK_COIN_SILVER:
-		case BLOCK_COIN_SPECIAL:
-			return true;
-		default:
-			return false;
-		}
+		return getBlockFlags(value) & BLOCK_FLAG_OBJECTIVE;
 	}
 }
@@ -6,24 +6,50 @@
 #include <stdio.h>
 #include <string>
 
+#include "Backgrounds.h"
+
 /// Contains standard constants for the XPlatformer game and associated files.
 namespace GameConstants
 {
-	enum BG
+	/// The shared state components read and write while updating (see Displayable::getUpdateReads).
+	enum ACCESS
 	{
-		/// Background ID for castle.
-		BG_CASTLE = 0,
+		/// The level grid and its resident chunks.
+		ACCESS_WORLD = 1 << 0,
+
+		/// The player's state.
+		ACCESS_PLAYER = 1 << 1,
+
+		/// The sun and clouds.
+		ACCESS_SKY = 1 << 2,
+
+		/// The camera position.
+		ACCESS_CAMERA = 1 << 3,
+
+		/// The keyboard and window state held by XInfo.
+		ACCESS_INPUT = 1 << 4
+	};
 
-		/// Background ID for desert.
-		BG_DESERT = 1,
+	/// The layers sprites are recorded on (see CommandBuffer), drawn in increasing order over the world.
+	enum LAYER
+	{
+		/// The sun and clouds.
+		LAYER_SKY = 0,
 
-		/// Background ID for grasslands.
-		BG_GRASSLANDS = 2,
+		/// The player.
+		LAYER_PLAYER = 1,
 
-		/// Background ID for mushrooms.
-		BG_SHROOM = 3
+		/// The score.
+		LAYER_HUD = 2
 	};
 
+	/// The size of the score layer, and the position of the score's baseline within it.  The score is outlined, so
+	/// it starts a pixel in from the left.
+	static const int SCORE_LAYER_WIDTH = 101;
+	static const int SCORE_LAYER_HEIGHT = 32;
+	static const int SCORE_LAYER_LEFT = 1;
+	static const int SCORE_LAYER_BASELINE = 25;
+
 	/// Number of states/animations available.
 	static const int PLAYER_ANIMATION_COUNT = 7;
 
@@ -38,4 +64,17 @@ namespace GameConstants
 
 	/// The default speed of clouds present in the SkyComponent.
 	static float DEFAULT_SKY_SPEED = 3.0f;
+
+	/// The number of tile chunks kept resident on each side of the player's chunk.
+	static const int WORLD_CHUNK_RADIUS = 2;
+
+	/// The size (in pixels) of the area in the middle of the screen the player can move within before the camera scrolls.
+	static float CAMERA_DEAD_ZONE_WIDTH = 200.0f;
+	static float CAMERA_DEAD_ZONE_HEIGHT = 140.0f;
+
+	/// How far the sky moves relative to the camera, so it appears further away than the world.
+	static const float SKY_PARALLAX = 0.25f;
+
+	/// The least time (in seconds) the loading screen stays up between levels, so its message can be read.
+	static const float LEVEL_SHIFT_MIN_TIME = 1.0f;
 }
@@ -0,0 +1,268 @@
+#pragma once
+
+#include <stdint.h>
+#include <cstring>
+#include <utility>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "Blocks.h"
+#include "Backgrounds.h"
+
+namespace GameConstants
+{
+	/// Identifies a level file and its layout version.
+	static const char LEVEL_MAGIC[8] = { 'X', 'G', 'L', 'E', 'V', 'E', 'L', 0 };
+	static const uint32_t LEVEL_VERSION = 1;
+
+	/// The tile value stored for BLOCK_EMPTY, as tiles are stored in a byte.
+	static const uint8_t LEVEL_TILE_EMPTY = 0xFF;
+
+	/// The largest width or height (in tiles) a level may have.
+	static const uint32_t LEVEL_MAX_SIZE = 1 << 20;
+}
+
+/// LevelHeader
+///	 The header at the start of a level file, followed by the tile layer.
+struct LevelHeader
+{
+	char magic[8];
+	uint32_t version;
+
+	/// The grid size in tiles
+	uint32_t width;
+	uint32_t height;
+
+	/// The background identifier id (GameConstants::BG)
+	int32_t background;
+
+	/// The player's starting position (in world coordinates)
+	int32_t spawnX;
+	int32_t spawnY;
+
+	/// The number of objective tiles in the tile layer
+	uint32_t objectiveCount;
+	uint32_t reserved;
+
+	/// The tile layer: one byte per cell, in grid index order (x + width * y, row 0 at the bottom)
+	uint64_t tileOffset;
+	uint64_t fileSize;
+};
+
+/// LevelFile
+///	 A read-only, memory-mapped level.  The header is checked when the file is opened, which costs nothing per
+///  tile; the tile layer is scanned once by validate, which must succeed before the world reads the tiles without
+///  further checks.  The header alone can be read without mapping the level (see readHeader).
+class LevelFile
+{
+public:
+	/// Initializes a new instance of LevelFile.
+	LevelFile(void)
+	{
+		file = NULL;
+		fileSize = 0;
+		header = NULL;
+	}
+
+	/// Disposes of the LevelFile instance, unmapping the level.
+	~LevelFile(void)
+	{
+		close();
+	}
+
+	/// Reads and checks the header of a level without mapping it.
+	///  @filename The path of the level file.
+	///  @header The header read.
+	///  @returns True if the header was read and is valid, false otherwise.
+	static bool readHeader(const char* filename, LevelHeader* header)
+	{
+		int fd = ::open(filename, O_RDONLY);
+		if(fd < 0)
+		{
+			return false;
+		}
+
+		struct stat info;
+		bool success = fstat(fd, &info) == 0 &&
+			pread(fd, header, sizeof(LevelHeader), 0) == (ssize_t)sizeof(LevelHeader) &&
+			isHeaderValid(*header, info.st_size);
+		::close(fd);
+		return success;
+	}
+
+	/// Maps a level and checks its header and that the tile layer lies within the file.  The tiles are not read.
+	///  @filename The path of the level file.
+	///  @returns True if the header is valid, false otherwise.
+	bool open(const char* filename)
+	{
+		close();
+
+		int fd = ::open(filename, O_RDONLY);
+		if(fd < 0)
+		{
+			return false;
+		}
+
+		struct stat info;
+		if(fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(LevelHeader))
+		{
+			::close(fd);
+			return false;
+		}
+
+		void* mapping = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		::close(fd);
+		if(mapping == MAP_FAILED)
+		{
+			return false;
+		}
+
+		file = (const char*)mapping;
+		fileSize = info.st_size;
+		header = (const LevelHeader*)file;
+
+		if(!isHeaderValid(*header, fileSize))
+		{
+			close();
+			return false;
+		}
+		return true;
+	}
+
+	/// Checks that every tile of an open level is a known block and that the objectives match the header.  This
+	/// reads the whole tile layer, so it is done once per level, away from the game loop where possible.
+	///  @returns True if the tile layer is valid, false otherwise.
+	bool validate(void)
+	{
+		uint64_t count = (uint64_t)header->width * header->height;
+		const uint8_t* tiles = getTiles();
+		uint32_t objectives = 0;
+		for(uint64_t i = 0; i < count; i++)
+		{
+			int value = toBlock(tiles[i]);
+			if(!BLOCKS::isBlockValid(value))
+			{
+				return false;
+			}
+			if(BLOCKS::isBlockObjective(value))
+			{
+				objectives++;
+			}
+		}
+
+		// validation read every page; drop them so only the parts of the level in use stay resident
+		madvise((void*)file, fileSize, MADV_DONTNEED);
+		return objectives == header->objectiveCount;
+	}
+
+	/// Exchanges the mapped levels of two instances, so a level opened elsewhere can be swapped in.
+	///  @other The instance to exchange with.
+	void swap(LevelFile& other)
+	{
+		std::swap(file, other.file);
+		std::swap(fileSize, other.fileSize);
+		std::swap(header, other.header);
+	}
+
+	/// Unmaps the level.
+	void close(void)
+	{
+		if(file != NULL)
+		{
+			munmap((void*)file, fileSize);
+		}
+		file = NULL;
+		fileSize = 0;
+		header = NULL;
+	}
+
+	/// Gets the width of the level grid.
+	///  @returns The grid width in tiles.
+	int getWidth(void) const
+	{
+		return header->width;
+	}
+
+	/// Gets the height of the level grid.
+	///  @returns The grid height in tiles.
+	int getHeight(void) const
+	{
+		return header->height;
+	}
+
+	/// Gets the background of the level.
+	///  @returns The background identifier id.
+	int getBackground(void) const
+	{
+		return header->background;
+	}
+
+	/// Gets the player's starting x-coordinate.
+	///  @returns The x-coordinate (in world coordinates).
+	int getSpawnX(void) const
+	{
+		return header->spawnX;
+	}
+
+	/// Gets the player's starting y-coordinate.
+	///  @returns The y-coordinate (in world coordinates).
+	int getSpawnY(void) const
+	{
+		return header->spawnY;
+	}
+
+	/// Gets the number of objectives in the level.
+	///  @returns The number of objective tiles.
+	int getObjectiveCount(void) const
+	{
+		return header->objectiveCount;
+	}
+
+	/// Gets the tile layer.
+	///  @returns The tiles in grid index order, with BLOCK_EMPTY stored as LEVEL_TILE_EMPTY.
+	const uint8_t* getTiles(void) const
+	{
+		return (const uint8_t*)(file + header->tileOffset);
+	}
+
+	/// Converts a stored tile to its block value.
+	///  @tile The stored tile.
+	///  @returns The block value.
+	static int toBlock(uint8_t tile)
+	{
+		return tile == GameConstants::LEVEL_TILE_EMPTY ? (int)BLOCK_EMPTY : tile;
+	}
+
+	/// Converts a block value to its stored tile.
+	///  @value The block value.
+	///  @returns The stored tile.
+	static uint8_t toTile(int value)
+	{
+		return value == BLOCK_EMPTY ? GameConstants::LEVEL_TILE_EMPTY : (uint8_t)value;
+	}
+
+private:
+	/// Checks the fields of a header, and that the tile layer it describes lies within the file.
+	static bool isHeaderValid(const LevelHeader& header, uint64_t size)
+	{
+		if(memcmp(header.magic, GameConstants::LEVEL_MAGIC, sizeof(GameConstants::LEVEL_MAGIC)) != 0 ||
+			header.version != GameConstants::LEVEL_VERSION ||
+			header.fileSize != size ||
+			header.width == 0 || header.width > GameConstants::LEVEL_MAX_SIZE ||
+			header.height == 0 || header.height > GameConstants::LEVEL_MAX_SIZE ||
+			header.background < GameConstants::BG_CASTLE || header.background > GameConstants::BG_SHROOM ||
+			header.spawnX < 0 || header.spawnY < 0)
+		{
+			return false;
+		}
+
+		uint64_t count = (uint64_t)header.width * header.height;
+		return header.tileOffset >= sizeof(LevelHeader) && header.tileOffset <= size && count <= size - header.tileOffset;
+	}
+
+	const char* file;
+	size_t fileSize;
+	const LevelHeader* header;
+};
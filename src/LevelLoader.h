@@ -0,0 +1,95 @@
+#pragma once
+
+#include <string>
+#include <thread>
+#include <atomic>
+
+#include "LevelFile.h"
+
+/// LevelLoader
+///	 Opens and validates a level on a background thread, so the next level's tile layer is scanned while the
+///  current one is played and the game thread only swaps the mapped level in (see LevelFile::swap).  One level
+///  is loaded at a time.
+class LevelLoader
+{
+public:
+	/// Initializes a new instance of LevelLoader with no level requested.
+	LevelLoader(void)
+	{
+		ready = false;
+		valid = false;
+	}
+
+	/// Disposes of the LevelLoader instance, waiting for the worker and unmapping an unclaimed level.
+	~LevelLoader(void)
+	{
+		wait();
+	}
+
+	/// Starts opening and validating a level.  Requesting the level already requested does nothing; requesting
+	/// another waits for the previous one and discards it.
+	///  @filename The path of the level file.
+	void request(const char* filename)
+	{
+		if(requested == filename)
+		{
+			return;
+		}
+
+		wait();
+		level.close();
+		requested = filename;
+		ready = false;
+		valid = false;
+		worker = std::thread(&LevelLoader::run, this);
+	}
+
+	/// Returns true if the requested level is still being opened or validated.
+	///  @returns True if the worker has not finished, false otherwise.
+	bool isPending(void)
+	{
+		return !requested.empty() && !ready;
+	}
+
+	/// Gets a requested level, waiting for the worker if it has not finished.  The level is meant to be swapped out
+	/// of the loader (see LevelFile::swap); whatever is swapped in is unmapped by the next request, rather than by
+	/// the caller.
+	///  @filename The path of the level file, as it was requested.
+	///  @returns The opened and validated level, or NULL if it was not requested or is invalid.
+	LevelFile* take(const char* filename)
+	{
+		if(requested != filename)
+		{
+			return NULL;
+		}
+
+		wait();
+		requested.clear();
+		return valid ? &level : NULL;
+	}
+
+private:
+	/// The worker: opens the requested level and reads its whole tile layer once.
+	void run(void)
+	{
+		valid = level.open(requested.c_str()) && level.validate();
+		ready = true;
+	}
+
+	/// Waits for the worker to finish, if one was started.
+	void wait(void)
+	{
+		if(worker.joinable())
+		{
+			worker.join();
+		}
+	}
+
+	std::thread worker;
+
+	/// The level requested and, once ready, opened; valid is only read after the worker is joined
+	std::string requested;
+	LevelFile level;
+	std::atomic<bool> ready;
+	bool valid;
+};
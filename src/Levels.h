@@ -1,149 +1,128 @@
 #pragma once
 
+#include <stdio.h>
+#include <unistd.h>
+
 #include "WorldComponent.h"
-#include "Blocks.h"
+#include "LevelFile.h"
+#include "LevelLoader.h"
+#include "Resources.h"
 
 #include "lib/Logger.h"
 
-///Number of levels available
-#define LEVEL_COUNT 3
+namespace Logger
+{
+	/// Level Messages
+	static const char* LOG_LEVELERROR = "# Level file is missing or invalid: ";
+}
 
 /// Levels
-///		Levels is fairly straightforward.  It is a class that contains functions that set specific indicies of the world to reflect certain blocks.
+///		Levels is fairly straightforward.  Levels are numbered files (see LevelFile.h and tools/exportlevels) that
+///		are mapped by the world when the level is set.
 namespace Levels
 {
-	/// Function used to define attributes of a level using the WorldComponent. Specifically level one.
-	///  @xinfo The graphics information for game.
-	///  @world The component control tool of the world.
-	void _loadWorldOne(XInfo* xinfo, WorldComponent &world)
+	/// Gets the path of a level file.
+	///  @index The index of the level.
+	///  @path The buffer receiving the path.
+	///  @length The size of the buffer.
+	void getLevelPath(int index, char* path, int length)
 	{
-		for(int x = 0; x < world.getWorldWidth(); x++)
-		{
-			if(x >= 3 && x <= 7)
-			{
-				world.setBlock(x, 1, BLOCK_BRIDGE);
-				world.setBlock(x, 0, BLOCK_WATER);
+		snprintf(path, length, Resources::ASSET_LEVEL_FORMAT, index);
+	}
 
-				world.setBlock(x, 4, BLOCK_PLANK);
-			}
-			else
+	/// Returns the number of levels available, counting consecutive level files from level one.
+	///  @returns The number of levels, at least one.
+	int getLevelCount(void)
+	{
+		static int count = 0;
+		if(count == 0)
+		{
+			char path[256];
+			do
 			{
-				world.setBlock(x, 1, BLOCK_GRASS);
-				world.setBlock(x, 0, BLOCK_DEFAULT);
+				count++;
+				getLevelPath(count + 1, path, sizeof(path));
 			}
+			while(access(path, R_OK) == 0);
 		}
-
-		world.setBlock(3, 2, BLOCK_COIN_GOLD);
-		world.setBlock(7, 2, BLOCK_COIN_GOLD);
-
-		world.setBlock(5, 2, BLOCK_KEY_RED);
-		world.setBlock(9, 2, BLOCK_LOCK_RED); 
-
-		world.loadBackground(xinfo, GameConstants::BG_GRASSLANDS);
+		return count;
 	}
 
-	/// Function used to define attributes of a level using the WorldComponent. Specifically level two.
-	///  @xinfo The graphics information for game.
-	///  @world The component control tool of the world.
-	void _loadWorldTwo(XInfo* xinfo, WorldComponent &world)
+	/// Returns the background of a level, so it can be prefetched before the level is set.
+	///  @index The index of the level.
+	///  @returns The background identifier id of the level, or the grasslands if the level cannot be read.
+	int getBackground(int index)
 	{
-		int top = 3;
-		for(int x = 0; x < top; x++)
-		{
-			world.setBlock(0, x, BLOCK_ROCK);
-			world.setBlock(1, x, BLOCK_ROCK);
+		char path[256];
+		getLevelPath(index, path, sizeof(path));
 
-			world.setBlock(world.getWorldWidth() - 1, x, BLOCK_ROCK);
-			world.setBlock(world.getWorldWidth() - 2, x, BLOCK_ROCK);
-		}
-
-		for(int x = 0; x < world.getWorldWidth(); x++)
+		// only the header is read, as the tile layer is validated when the level is set
+		LevelHeader header;
+		if(!LevelFile::readHeader(path, &header))
 		{
-			if(x > 1 && x < world.getWorldWidth() - 2)
-			{
-				world.setBlock(x, 0, BLOCK_ROCK);
-				world.setBlock(x, 1, BLOCK_LAVA);
-			}
-
-			if (x < 4 || x > 6)
-			{
-				world.setBlock(x, top, BLOCK_ROCK);
-			}
+			return GameConstants::BG_GRASSLANDS;
 		}
-
-		world.setBlock(world.getWorldWidth() - 3, top + 1, BLOCK_COIN_GOLD);
-		world.setBlock(5, 3, BLOCK_COIN_GOLD);
-
-		world.loadBackground(xinfo, GameConstants::BG_CASTLE);
+		return header.background;
 	}
 
-	/// Function used to define attributes of a level using the WorldComponent. Specifically level three.
+	/// Function used to define attributes of a level using the WorldComponent.
 	///  @xinfo The graphics information for game.
 	///  @world The component control tool of the world.
-	void _loadWorldThree(XInfo* xinfo, WorldComponent &world)
+	///  @index The index defining which level to set the world too.  Default is world one.
+	void setLevel(XInfo* xinfo, WorldComponent &world, int index)
 	{
-		for(int x = 0; x < world.getWorldWidth(); x++)
+		if(index < 1 || index > getLevelCount())
 		{
-			world.setBlock(x, 0, BLOCK_DEFAULT);
-			world.setBlock(x, 1, BLOCK_SAND);
+			index = 1;
 		}
 
-		int platfrm = 5;
-		for(int x = 0; x < platfrm; x++)
-		{
-			world.setBlock(0, x, BLOCK_DEFAULT);
-		}
-		world.setBlock(0, platfrm, BLOCK_SAND);
-
-		int level1 = 5;
-		for(int x = 0; x < level1; x++)
-		{
-			world.setBlock(x + 4, platfrm, BLOCK_SAND);
-		}
+		char path[256];
+		getLevelPath(index, path, sizeof(path));
 
-		for(int x = 0; x < 2; x++)
+		if(!world.loadLevel(path))
 		{
-			world.setBlock(x + 8, 2, BLOCK_SAND);
-			world.setBlock(x + 8, 1, BLOCK_DEFAULT);
+			Logger::application_debug(Logger::LOG_LEVELERROR, path);
+			Logger::application_error(Logger::LOG_ERROR);
 		}
 
-		for(int y = 0; y < 3; y++)
-		{
-			world.setBlock(10, y, BLOCK_DEFAULT);
-			world.setBlock(11, y, BLOCK_DEFAULT);
-		}
-		world.setBlock(10, 3, BLOCK_SAND);
-		world.setBlock(11, 3, BLOCK_SAND);
-
-		world.setBlock(5, platfrm + 1, BLOCK_KEY_BLUE);
-		world.setBlock(5, platfrm, BLOCK_LOCK_GREEN);
+		world.loadBackground(xinfo, world.getBackground());
+	}
 
-		world.setBlock(5, 3, BLOCK_KEY_GREEN);
-		world.setBlock(5, 2, BLOCK_LOCK_BLUE);
+	/// Starts opening and validating a level and decoding its background in the background, so it can be set
+	/// with setPrefetchedLevel without reading the level on the game thread.
+	///  @xinfo The graphics information for game.
+	///  @world The component control tool of the world.
+	///  @loader The loader the level is opened on.
+	///  @index The index of the level.
+	void prefetchLevel(XInfo* xinfo, WorldComponent &world, LevelLoader &loader, int index)
+	{
+		char path[256];
+		getLevelPath(index, path, sizeof(path));
 
-		world.loadBackground(xinfo, GameConstants::BG_DESERT);
+		loader.request(path);
+		world.prefetchBackground(xinfo, getBackground(index));
 	}
 
-	/// Function used to define attributes of a level using the WorldComponent.
+	/// Sets a level started by prefetchLevel, swapping in the mapped level and the decoded background.  Nothing
+	/// is read from the level file, so this is cheap enough to run under the render lock once the loader and the
+	/// background have finished.
 	///  @xinfo The graphics information for game.
 	///  @world The component control tool of the world.
-	///  @index The index defining which level to set the world too.  Default is world one.
-	void setLevel(XInfo* xinfo, WorldComponent &world, int index)
+	///  @loader The loader the level was opened on.
+	///  @index The index of the level.
+	void setPrefetchedLevel(XInfo* xinfo, WorldComponent &world, LevelLoader &loader, int index)
 	{
-		switch(index)
+		char path[256];
+		getLevelPath(index, path, sizeof(path));
+
+		LevelFile* prepared = loader.take(path);
+		if(prepared == NULL)
 		{
-		case 1:
-			_loadWorldOne(xinfo, world);
-			break;
-		case 2:
-			_loadWorldTwo(xinfo, world);
-			break;
-		case 3:
-			_loadWorldThree(xinfo, world);
-			break;
-		default:
-			_loadWorldOne(xinfo, world);
-			break;
+			Logger::application_debug(Logger::LOG_LEVELERROR, path);
+			Logger::application_error(Logger::LOG_ERROR);
 		}
+
+		world.loadLevel(*prepared);
+		world.loadBackground(xinfo, world.getBackground());
 	}
 }
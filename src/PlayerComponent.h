@@ -1,9 +1,7 @@
 #pragma once
 
 /// Standard libraries
-#include <cstdio>
 #include <string>
-#include <sstream>
 #include <stdlib.h>
 
 /// X11/XLib libraries
@@ -18,6 +16,9 @@
 #include "lib/Animation.h"
 #include "lib/Constants.h"
 #include "lib/Logger.h"
+#include "lib/Allocations.h"
+#include "lib/HudLayer.h"
+#include "lib/Format.h"
 
 /// Project components
 #include "PlayerComponent.h"
@@ -26,6 +27,13 @@
 #include "Resources.h"
 #include "GameConstants.h"
 
+namespace Logger
+{
+	/// Player Messages
+	static const char* INFO_COLLISIONALLOCS = "# Collision heap allocations = ";
+	static const char* INFO_SCORERENDERS = "# Score layer renders = ";
+}
+
 /// The current action that the player is performing.
 enum PLAYER_ACTION
 {
@@ -73,6 +81,20 @@ enum PLAYER_HEALTH
 	DEAD = 2
 };
 
+/// PlayerPose
+///  The state of the player that is drawn, published after each frame's updates.
+struct PlayerPose
+{
+	/// The position, and the position before the last update
+	float x;
+	float y;
+	float previousX;
+	float previousY;
+
+	int animIndex;
+	unsigned int score;
+};
+
 /// PlayerComponent
 ///  The player component defines the player.  It handles interaction, state, animation,
 ///  updating and drawing.
@@ -82,10 +104,15 @@ class PlayerComponent :
 public:
 	/// Initializes a new instance of PlayerComponent.
 	///  @worldComp The world component that handles the world the player exists within.
-	PlayerComponent(WorldComponent* worldComp)
+	PlayerComponent(WorldComponent* worldComp) :
+		poses()
 	{
 		world = worldComp;
+		sheet = NULL;
 		player_score = 0;
+		collisionAllocations = 0;
+		hudScore = 0;
+		hudScoreSet = false;
 	}
 
 	/// Disposes of the PlayerComponent instance.
@@ -96,23 +123,35 @@ public:
 	/// Overloaded. Draws the Displayable component to the screen.
 	virtual void draw(XInfo* xinfo, GameTime* gameTime)
 	{
-		///Gets the player position as integers
-		int plyrx = MATH::ifloor(position->getX());
-		int plyry = MATH::ifloor(position->getY());
+		const PlayerPose& pose = poses[getDrawSlot()];
 
-		// Set clip mask and draw from spritesheet (based on position and current animation index)
-		xinfo->setMask(img_mask);
-		xinfo->draw(sheet, plyrx, plyry, currentAnimIndex);
-		xinfo->clearMask();
+		///Gets the player position on screen as integers, interpolated between the last two simulation steps
+		float alpha = gameTime->getAlpha();
+		int plyrx = getView()->toScreenX(MATH::ifloor(MATH::lerp(pose.previousX, pose.x, alpha)));
+		int plyry = getView()->toScreenY(MATH::ifloor(MATH::lerp(pose.previousY, pose.y, alpha)));
 
-		// Creates a stringstream to display the score
-		std::stringstream ss_score;
-		ss_score<< player_score << std::endl; //add endl for special character
-		std::string score_text = ss_score.str();
+		// Record the sprite from spritesheet (based on position and current animation index)
+		CommandBuffer* commands = getCommandBuffer();
+		commands->drawSprite(GameConstants::LAYER_PLAYER, sheet, img_mask, plyrx, plyry, pose.animIndex);
 
-		// Draw score text to screen
+		// The score is formatted, and its layer rendered, only when it changes
+		if(!hudScoreSet || pose.score != hudScore)
+		{
+			char score_text[SCORE_TEXT_LENGTH];
+			char* end = Format::toChars(score_text, score_text + SCORE_TEXT_LENGTH - 2, pose.score);
+			*end++ = '\n'; //add newline for special character
+			*end = '\0';
+
+			hud.setString(0, score_text, GameConstants::SCORE_LAYER_LEFT, GameConstants::SCORE_LAYER_BASELINE, 16766720);
+			hudScore = pose.score;
+			hudScoreSet = true;
+		}
+
+		// Record the score layer over everything else
 		Rectangle* rect = xinfo->getGraphicBounds();
-		xinfo->drawString(score_text, rect->getWidth() - 100, rect->getHeight() - 50, 16766720);
+		int scoreX = rect->getWidth() - 100 - GameConstants::SCORE_LAYER_LEFT;
+		int scoreY = rect->getHeight() - 50 - GameConstants::SCORE_LAYER_BASELINE;
+		hud.draw(xinfo, commands, GameConstants::LAYER_HUD, scoreX, scoreY);
 	}
 
 	/// Overloaded. Updates the Displable component based on recent changes.
@@ -154,7 +193,10 @@ public:
 			// }
 		}
 
+		previousPosition.set(position.getX(), position.getY());
 		applyPhysics(gameTime);
+		world->setFocus(position.getX(), position.getY());
+		getCamera()->follow(position.getX(), position.getY(), sheet->getSpriteWidth(), sheet->getSpriteHeight());
 
 		float time = gameTime->getElapsedDelta();
 		elapsedTime += time * moveSpeed / 2.5;
@@ -162,30 +204,51 @@ public:
 		handleAnimation(newState, newDirection);
 	}
 
+	/// Overloaded. Publishes the position, animation and score for drawing.
+	virtual void publish(int slot)
+	{
+		PlayerPose& pose = poses[slot];
+		pose.x = position.getX();
+		pose.y = position.getY();
+		pose.previousX = previousPosition.getX();
+		pose.previousY = previousPosition.getY();
+		pose.animIndex = currentAnimIndex;
+		pose.score = player_score;
+	}
+
 	/// Overloaded. Loads an asset that is needed for the component.
 	virtual void load(XInfo* xinfo)
 	{
-		bool success = xinfo->loadImage(Resources::ASSET_PLAYERSHEET, &img_player, Resources::ASSET_PLAYERSHEET_MASK, &img_mask);
+		bool success = xinfo->loadImage(Resources::ASSET_PLAYERSHEET, &img_player, &img_mask);
 		if(!success)
 		{
 			Logger::application_error(Logger::LOG_ASSETERROR);
 		}
 
 		sheet = new Spritesheet(img_player, 27, 1, 1);
+		xinfo->upload(img_player);
 
 		float swidth = (float)sheet->getSpriteWidth();
 		float sheight = (float)sheet->getSpriteHeight();
 		dist_To_special = sqrt(swidth * swidth + sheight * sheight) / 1.5f;
 
-		screenXEdge = (xinfo->getImageWidth() - sheet->getSpriteWidth());
-		screenYEdge = (xinfo->getImageHeight() - sheet->getSpriteHeight());
+		getCamera()->focus(position.getX(), position.getY(), swidth, sheight);
+
+		hud.load(xinfo, GameConstants::SCORE_LAYER_WIDTH, GameConstants::SCORE_LAYER_HEIGHT);
 	}
 
 	/// Overloaded. Disposes all data that was loaded by this Displayable.
 	virtual void unload(XInfo* xinfo)
 	{
-		XDestroyImage(img_player);
-		XFreePixmap(xinfo->getDisplay(), img_mask);
+		xinfo->destroyImage(img_player);
+		xinfo->freePixmap(img_mask);
+		hud.unload(xinfo);
+		Logger::application_info(Logger::INFO_SCORERENDERS, hud.getRenderCount());
+
+		if(Allocations::isCounting())
+		{
+			Logger::application_info(Logger::INFO_COLLISIONALLOCS, collisionAllocations);
+		}
 	}
 
 	/// Overloaded. Initializes required services and loads any non-graphics resources.
@@ -198,10 +261,27 @@ public:
 		reset();
 	}
 
+	/// Overloaded. Gets the name used to report the component.
+	virtual const char* getName(void)
+	{
+		return "Player";
+	}
+
+	/// Overloaded. Gets the shared state read while updating.
+	virtual unsigned int getUpdateReads(void)
+	{
+		return GameConstants::ACCESS_PLAYER | GameConstants::ACCESS_WORLD | GameConstants::ACCESS_INPUT;
+	}
+
+	/// Overloaded. Gets the shared state written while updating.
+	virtual unsigned int getUpdateWrites(void)
+	{
+		return GameConstants::ACCESS_PLAYER | GameConstants::ACCESS_WORLD | GameConstants::ACCESS_CAMERA;
+	}
+
 	/// Resets the player to the initial default game state.
 	void reset(void)
 	{
-		sleep(1);
 		state = PLAYER_IDLE;
 		direction = PLAYER_FRONT;
 		health = ALIVE;
@@ -213,9 +293,16 @@ public:
 		xVelocity = 0;
 		yVelocity = gravity;
 
-		position = new Vector2(10, 10);
+		position.set(world->getSpawnX(), world->getSpawnY());
+		previousPosition.set(position.getX(), position.getY());
 		isOnGround = false;
 
+		// the camera jumps to the spawn point rather than scrolling from the previous level
+		if(sheet != NULL)
+		{
+			getCamera()->focus(position.getX(), position.getY(), sheet->getSpriteWidth(), sheet->getSpriteHeight());
+		}
+
 		maxFallSpeed = jumpSpeed * 0.13f;
 		maxJumpTime = 0.35f;
 		maxMoveSpeed = moveSpeed * 1.0f;
@@ -307,27 +394,29 @@ public:
 	}
 
 private:
-	Rectangle* getBounding(void)
+	/// The length of the score text buffer, enough for any score and the trailing characters.
+	static const int SCORE_TEXT_LENGTH = 16;
+
+	Rectangle getBounding(void)
 	{
-		float left = round(position->getX());
-		float top = round(position->getY());
+		float left = round(position.getX());
+		float top = round(position.getY());
 		float width = (float)sheet->getSpriteWidth();
 		float height = (float)sheet->getSpriteHeight();
 
-		return new Rectangle(left, top, width, height);
+		return Rectangle(left, top, width, height);
 	}
 
 	void applyPhysics(GameTime* gameTime)
 	{
 		float elapsed = gameTime->getElapsedDelta();
-		Vector2 initialPosition(position->getX(), position->getY());
+		Vector2 initialPosition(position.getX(), position.getY());
 
 		xVelocity = movement * moveSpeed * elapsed;
 		yVelocity += MATH::clamp(yVelocity + gravity * elapsed, -maxFallSpeed, maxFallSpeed);
 
 		if (state == PLAYER_JUMP)
 		{
-			std::cout << jumpTime << std::endl;
 			if (0.0f <= jumpTime && jumpTime <= maxJumpTime)
 			{
 				jumpTime += elapsed;
@@ -347,17 +436,31 @@ private:
 
 		float xMove = round(xVelocity * elapsed);
 		float yMove = round(yVelocity * elapsed);
-		position->move(xMove, yMove);
 
-		// If the player is now colliding with the level, separate them.
+		// Sweep each axis through the grid, stopping at the first blocking cell on the way, so a long
+		// step (a low tick rate or a stall) cannot carry the player through a wall or platform.
+		position.move(world->sweepX(getBounding(), xMove), 0);
+
+		float yAllowed = world->sweepY(getBounding(), yMove);
+		position.move(0, yAllowed);
+		if (yMove > 0)
+		{
+			isOnGround = yAllowed < yMove;
+		}
+
+		// Separate the player from cells it already overlapped (such as a spawn point inside the ground) and
+		// collect items.  Collision runs every step, so it must not allocate; the count is reported on
+		// unload when counting is compiled in.
+		unsigned long allocations = Allocations::getCount();
 		handleCollision();
+		collisionAllocations += Allocations::getCount() - allocations;
 
-		if (position->getX() == initialPosition.getX())
+		if (position.getX() == initialPosition.getX())
 		{
 			xVelocity = 0;
 		}
 
-		if (position->getY() == initialPosition.getY())
+		if (position.getY() == initialPosition.getY())
 		{
 			yVelocity = 0;
 		}
@@ -366,29 +469,30 @@ private:
 
 	void handleCollision()
 	{
-		Rectangle* bounds = getBounding();
+		Rectangle bounds = getBounding();
 		float width = (float)sheet->getSpriteWidth();
 		float height = (float)sheet->getSpriteHeight();
 
 		int topOfIt = (world->getWorldHeight() - 1);
 
-		int leftBlock = MATH::ifloor(bounds->getLeft() / width);
-		int rightBlock = MATH::iceiling((bounds->getRight() / width)) + 1;
-		int topBlock = topOfIt - MATH::iceiling(bounds->getTop() / height);
-		int bottomBlock = MATH::iclamp(topOfIt - MATH::ifloor((bounds->getBottom() / height)) - 1, 0, topOfIt);
+		int leftBlock = MATH::ifloor(bounds.getLeft() / width);
+		int rightBlock = MATH::iceiling((bounds.getRight() / width)) + 1;
+		int topBlock = topOfIt - MATH::iceiling(bounds.getTop() / height);
+		int bottomBlock = MATH::iclamp(topOfIt - MATH::ifloor((bounds.getBottom() / height)) - 1, 0, topOfIt);
 
 		for(int y = bottomBlock; y <= topBlock; y++)
 		{
+			// cells past the edges of the world read as blocking, so the row needs no bounds checks
+			uint32_t blocking = world->getBlockingRow(leftBlock, y, rightBlock - leftBlock + 1);
+
 			for(int x = leftBlock; x <= rightBlock; x++)
 			{
-				Rectangle* wRect = world->getWorldBlock(x, y);
+				Rectangle wRect = world->getWorldBlock(x, y);
 
-				int currVal = world->getBlock(x, y);
-
-				if(!BLOCKS::isBlockSolid(currVal) || BLOCKS::isBlockObjective(currVal))
+				if(!(blocking & (1u << (x - leftBlock))))
 				{
-					float xSDist = bounds->getCenterX() - wRect->getCenterX();
-					float ySDist = bounds->getCenterY()- wRect->getCenterY();
+					float xSDist = bounds.getCenterX() - wRect.getCenterX();
+					float ySDist = bounds.getCenterY()- wRect.getCenterY();
 					float distTo = sqrt(xSDist * xSDist + ySDist * ySDist);
 
 					if(distTo < dist_To_special)
@@ -398,36 +502,32 @@ private:
 					continue;
 				}
 
-				Vector2* depth = MATH::getIntersectionDepth(bounds, wRect);
-				if (depth->getX() != 0 && depth->getY() != 0)
+				// blocking cells are impassable and never platforms (see BLOCK_FLAG_BLOCKING)
+				Vector2 depth = MATH::getIntersectionDepth(bounds, wRect);
+				if (depth.getX() != 0 && depth.getY() != 0)
 				{
-					float absDepthX = abs(depth->getX());
-					float absDepthY = abs(depth->getY());
+					float absDepthX = abs(depth.getX());
+					float absDepthY = abs(depth.getY());
 
 					// Resolve the collision along the shallow axis.
-					if (absDepthY < absDepthX || BLOCKS::isBlockPlatform(currVal))
+					if (absDepthY < absDepthX)
 					{
 						// If we crossed the top of a tile, we are on the ground.
-						if (previousBottom <= wRect->getTop())
+						if (previousBottom <= wRect.getTop())
 						{
 							isOnGround = true;
 						}
 
-						// Ignore platforms, unless we are on the ground.
-						if (BLOCKS::isBlockImpassable(currVal) || isOnGround)
-						{
-							// Resolve the collision along the Y axis.
-							position->move(0, depth->getY());
-
-							// Perform further collisions with the new bounds.
-							bounds = getBounding();
+						// Resolve the collision along the Y axis.
+						position.move(0, depth.getY());
 
-						}
+						// Perform further collisions with the new bounds.
+						bounds = getBounding();
 					}
-					else if (BLOCKS::isBlockImpassable(currVal))
+					else
 					{
 						// Resolve the collision along the X axis.
-						position->move(depth->getX(), 0);
+						position.move(depth.getX(), 0);
 
 						// Perform further collisions with the new bounds.
 						bounds = getBounding();
@@ -439,12 +539,14 @@ private:
 			}
 
 			// Save the new bounds bottom
-			previousBottom = bounds->getBottom();
+			previousBottom = bounds.getBottom();
 		}
 
-		// Restrict bounds of object
-		position->setX(MATH::clamp(position->getX(), 0, screenXEdge));
-		position->setY(MATH::clamp(position->getY(), 0, screenYEdge));
+		// Restrict bounds of object to the world
+		float worldXEdge = world->getWorldWidth() * world->getBlockWidth() - width;
+		float worldYEdge = world->getWorldHeight() * world->getBlockHeight() - height;
+		position.setX(MATH::clamp(position.getX(), 0, worldXEdge));
+		position.setY(MATH::clamp(position.getY(), 0, worldYEdge));
 	}
 
 	void initAnimation(void)
@@ -587,10 +689,6 @@ private:
 	Pixmap img_mask;
 	Spritesheet* sheet;
 
-	/// Edges of the screen
-	float screenXEdge;
-	float screenYEdge;
-
 	/// Distance to special items (keys/coins)
 	float dist_To_special;
 
@@ -599,8 +697,9 @@ private:
 	unsigned int player_score;
 	int actionPressed;
 
-	/// The player x/y coordinates
-	Vector2* position;
+	/// The player x/y coordinates, and the coordinates before the last update
+	Vector2 position;
+	Vector2 previousPosition;
 	float movement;
 	float maxFallSpeed;
 	float maxJumpTime;
@@ -610,6 +709,14 @@ private:
 	float jumpTime;
 	float previousBottom;
 
+	/// Heap allocations made while resolving collisions
+	unsigned long collisionAllocations;
+
+	/// The score layer, and the score it was last set to
+	HudLayer hud;
+	unsigned int hudScore;
+	bool hudScoreSet;
+
 	/// Speed/velocity components
 	float jumpSpeed;
 	float moveSpeed;
@@ -633,4 +740,7 @@ private:
 	int currentAnimIndex;
 	Animation* currAnimation;
 	Animation* animations[GameConstants::PLAYER_ANIMATION_COUNT];
+
+	/// The state drawn, in the game's snapshot slots
+	PlayerPose poses[Constants::TRIPLE_BUFFER_SLOTS];
 };
@@ -14,15 +14,12 @@ namespace Resources
 
 	/// Sky Assets
 	static const char* ASSET_SKYSHEET = "assets/sky/spritesheet.tga";
-	static const char* ASSET_SKYSHEET_MASK = "assets/sky/spritesheet.xbm";
 
 	/// Player Assets
 	static const char* ASSET_PLAYERSHEET = "assets/player/spritesheet.tga";
-	static const char* ASSET_PLAYERSHEET_MASK = "assets/player/spritesheet.xbm";
 
 	/// World Assets
 	static const char* ASSET_WORLDSHEET = "assets/world/spritesheet.tga";
-	static const char* ASSET_WORLDSHEET_MASK = "assets/world/spritesheet.xbm";
 
 	/// Asset Backgrounds
 	static const char* ASSET_BG_CASTLE = "assets/backgrounds/bg_castle.tga";
@@ -30,6 +27,9 @@ namespace Resources
 	static const char* ASSET_BG_GRASSLANDS = "assets/backgrounds/bg_grasslands.tga";
 	static const char* ASSET_BG_SHROOM = "assets/backgrounds/bg_shroom.tga";
 
+	/// Level Files, numbered from one
+	static const char* ASSET_LEVEL_FORMAT = "assets/levels/level%d.lvl";
+
 	/// String Assets
 	static const char* ASSET_INFO_SPACE = "Press SPACE to Play";
 	static const char* ASSET_INFO_MOVEMENT = "Use Arrows Keys to Move";
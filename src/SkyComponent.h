@@ -3,9 +3,11 @@
 #include <cstdlib>
 #include <cstdio>
 #include <cmath>
-#include <list>
+#include <vector>
 
 #include "lib/Displayable.h"
+#include "lib/EntityStore.h"
+#include "lib/MathHelper.h"
 #include "lib/Logger.h"
 
 #include "SkyComponent.h"
@@ -14,22 +16,9 @@
 
 using namespace std;
 
-/// CloudComponent
-///  Central class for all sky game components.
-class CloudComponent {
-public:
-	/// The horizontal movement speed of the cloud.
-	float speed;
-
-	/// The horiontal position of the cloud.
-	float x;
-
-	/// The vertical position of the cloud.
-	float y;
-};
-
 /// SkyComponent
-///  Central class for all sky game components.
+///  Central class for all sky game components.  The sun and clouds are entities in an EntityStore, moved and
+///  drawn by the entity systems.
 class SkyComponent : public Displayable
 {
 public:
@@ -48,126 +37,123 @@ public:
 	/// Overloaded. Draws the Displayable component to the screen.
 	virtual void draw(XInfo* xinfo, GameTime* gameTime)
 	{
-		//set clipmask for spritesheet
-		xinfo->setMask(img_mask);
-
-		int sunx = (int)floor(sun_x);
-		int suny = (int)floor(sun_y);
-
-		xinfo->draw(sheet, sunx, suny, 3);
-
-		int i = 0;
-		list<CloudComponent*>::const_iterator begin = clouds.begin();
-		list<CloudComponent*>::const_iterator end = clouds.end();
-
-		while(begin != end)
-		{
-			CloudComponent* comp = *begin;
-			int cldx = (int)floor(comp->x);
-			int cldy = (int)floor(comp->y);
-
-			xinfo->draw(sheet, cldx, cldy, i);
-
-			begin++;
-			i++;
-		}
+		// the sky scrolls slower than the world, so it appears further away
+		int offset = (int)floor(getView()->getX() * GameConstants::SKY_PARALLAX);
 
-		//remove spritesheet from clipmask
-		xinfo->clearMask();
+		//record the sun and clouds interpolated between the last two simulation steps, behind the player
+		EntitySystems::draw(snapshots[getDrawSlot()], xinfo, getCommandBuffer(), GameConstants::LAYER_SKY, sheet, img_mask,
+			gameTime->getAlpha(), -offset, 0);
 	}
 
 	/// Overloaded. Updates the Displable component based on recent changes.
 	virtual void update(XInfo* xinfo, GameTime* gameTime)
 	{
-		float time = gameTime->getElapsedDelta();
-		int outerBound = xinfo->getGraphicBounds()->getWidth() + END_BOUND;
-
-		float sun_xMove = time * sun_speed;
-		float xsun = sun_x;
-		xsun += sun_xMove;
-
-		//check if sun is outside edge of screen
-		//reset sun position to left side of screen
-		if(xsun > outerBound)
-		{
-			xsun = WORLD_END;
-		}
-		sun_x = xsun;
+		EntitySystems::integrate(entities, gameTime->getElapsedDelta());
 
-		int i = 0;
-		list<CloudComponent*>::const_iterator begin = clouds.begin();
-		list<CloudComponent*>::const_iterator end = clouds.end();
+		//reset the sun and clouds to the left side of the screen once they pass the right edge
+		int outerBound = xinfo->getGraphicBounds()->getWidth() + END_BOUND;
+		int count = entities.getCount();
+		float* x = entities.getX();
+		float* previousX = entities.getPreviousX();
 
-		while(begin != end)
+		for(int i = 0; i < count; i++)
 		{
-			CloudComponent* comp = *begin;
-			float cloud_xMove = time * comp->speed;
-			float xpos = comp->x;
-			xpos += cloud_xMove;
-
-			if(xpos > outerBound)
+			if(x[i] > outerBound)
 			{
-				xpos = WORLD_END; //reset point
+				x[i] = WORLD_END;
+				previousX[i] = WORLD_END;
 			}
-			comp->x = xpos;
-
-			begin++;
-			i++;
 		}
 	}
 
+	/// Overloaded. Publishes the sun and clouds for drawing.  The copy reuses the storage of the slot, so it does
+	/// not allocate once the slot has held as many entities.
+	virtual void publish(int slot)
+	{
+		snapshots[slot] = entities;
+	}
+
 	/// Overloaded. Loads an asset that is needed for the component.
 	virtual void load(XInfo* xinfo)
 	{
 		//sky spritesheet
-		bool success = xinfo->loadImage(Resources::ASSET_SKYSHEET, &img_sky, Resources::ASSET_SKYSHEET_MASK, &img_mask);
+		bool success = xinfo->loadImage(Resources::ASSET_SKYSHEET, &img_sky, &img_mask);
 		if(!success)
 		{
 			Logger::application_error(Logger::LOG_ASSETERROR);
 		}
 
 		sheet = new Spritesheet(img_sky, 2, 2, 1);
+		xinfo->upload(img_sky);
 	}
 
 	/// Overloaded. Disposes all data that was loaded by this Displayable.
 	virtual void unload(XInfo* xinfo)
 	{
-		XFreePixmap(xinfo->getDisplay(), img_mask);
-		XDestroyImage(img_sky);
+		xinfo->freePixmap(img_mask);
+		xinfo->destroyImage(img_sky);
 	}
 
 	/// Overloaded. Initializes required services and loads any non-graphics resources.
 	virtual void initialize(XInfo* xinfo)
 	{
-		sun_x = 0;
-		sun_y = 20;
+		entities.clear();
+		clouds.clear();
+
+		sun = entities.create(COMPONENT_POSITION | COMPONENT_VELOCITY | COMPONENT_SPRITE);
+		int index = entities.getIndex(sun);
+		entities.setPosition(index, 0, 20);
+		entities.getVelocityX()[index] = sun_speed;
+		entities.setSprite(index, SUN_SPRITE, SUN_SPRITE);
 
 		for(int i = 0; i < ccount; i++)
 		{
-			CloudComponent* cComponent = createComponent(sun_speed);
-
 			// Cloud speed can be within range of [70% sun speed, 150% sun speed]
-			clouds.push_front(cComponent);
+			createCloud(sun_speed);
 		}
 	}
 
+	/// Overloaded. Gets the name used to report the component.
+	virtual const char* getName(void)
+	{
+		return "Sky";
+	}
+
+	/// Overloaded. Gets the shared state read while updating.
+	virtual unsigned int getUpdateReads(void)
+	{
+		return GameConstants::ACCESS_SKY | GameConstants::ACCESS_INPUT;
+	}
+
+	/// Overloaded. Gets the shared state written while updating.
+	virtual unsigned int getUpdateWrites(void)
+	{
+		return GameConstants::ACCESS_SKY;
+	}
+
 	/// Creates a cloud to be added to the sky component.
 	///  @speed The horizontal movement speed.
-	CloudComponent* createComponent(float relSpeed)
+	void createCloud(float relSpeed)
 	{
-		CloudComponent* cComponent = new CloudComponent();
+		Entity cloud = entities.create(COMPONENT_POSITION | COMPONENT_VELOCITY | COMPONENT_SPRITE);
+		int index = entities.getIndex(cloud);
 
 		// Random positions for the clouds to originate
-		cComponent->x = rand() % 800;
-		cComponent->y = rand() % 50;
+		float x = rand() % 800;
+		float y = rand() % 50;
+		entities.setPosition(index, x, y);
 
 		// rand is between [0, 8] + 7 = [7, 15]
 		int ranVal = (rand() % 9) + 7;
 
 		// Divide equal ranVal by 10.0 (reducing it to a float [0.7, 1.5] or [70%, 150%]
-		cComponent->speed = relSpeed * (ranVal / 10.0);
+		entities.getVelocityX()[index] = relSpeed * (ranVal / 10.0);
+
+		// each cloud takes the next cloud sprite of the sheet
+		int sprite = clouds.size() % CLOUD_SPRITES;
+		entities.setSprite(index, sprite, sprite);
 
-		return cComponent;
+		clouds.push_back(cloud);
 	}
 
 	/// Sets the horizontal movement speed of the sun.
@@ -175,6 +161,12 @@ public:
 	void setSunSpeed(float speed)
 	{
 		sun_speed = speed;
+
+		int index = entities.getIndex(sun);
+		if(index >= 0)
+		{
+			entities.getVelocityX()[index] = speed;
+		}
 	}
 
 	/// Gets the current horizontal movement speed of the sun.
@@ -194,24 +186,15 @@ public:
 	/// Sets the number of clouds present in the sky.
 	void setCloudCount(int count)
 	{
-		int diff = 0;
-		if (count > ccount)	{
-			diff = count - ccount;
-			while(diff > 0)
-			{
-				CloudComponent* cmp = clouds.back();
-				free(cmp);
-				clouds.pop_back();
-				diff--;
-			}
-		} else {
-			diff = ccount - count;
-			while(diff > 0)
-			{
-				CloudComponent* cmp = createComponent(sun_speed);
-				clouds.push_front(cmp);
-				diff--;
-			}
+		while((int)clouds.size() > count)
+		{
+			entities.destroy(clouds.back());
+			clouds.pop_back();
+		}
+
+		while((int)clouds.size() < count)
+		{
+			createCloud(sun_speed);
 		}
 
 		ccount = count;
@@ -220,15 +203,20 @@ public:
 private:
 	/// Sun components
 	float sun_speed;
-	float sun_x;
-	float sun_y;
+	Entity sun;
 
 	/// Constants
 	static constexpr float END_BOUND = 200.0f;
 	static constexpr float WORLD_END = -200.0f;
 
-	/// Cloud Components (Speed/X/Y)
-	std::list<CloudComponent*> clouds;
+	/// The sprite of the sun, and the number of cloud sprites before it in the sheet
+	static const int SUN_SPRITE = 3;
+	static const int CLOUD_SPRITES = 3;
+
+	/// The sun and clouds, and the handles of the clouds in the order they were created
+	EntityStore entities;
+	EntityStore snapshots[Constants::TRIPLE_BUFFER_SLOTS];
+	std::vector<Entity> clouds;
 	int ccount;
 
 	Pixmap img_mask;
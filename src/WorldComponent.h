@@ -1,24 +1,51 @@
 #pragma once
 
 #include <cstdio>
+#include <cstdlib>
 #include <sstream>
 #include <cmath>
 #include <string>
-#include <cstdio>
+#include <vector>
+#include <algorithm>
 
 #include "lib/Constants.h"
 #include "lib/Displayable.h"
 #include "lib/Spritesheet.h"
+#include "lib/TileMap.h"
+#include "lib/MathHelper.h"
 #include "lib/Logger.h"
 
 #include "WorldComponent.h"
 #include "GameConstants.h"
 #include "Blocks.h"
+#include "LevelFile.h"
 #include "Resources.h"
 
 // Retrieves the single index from the two dimensional index.
 #define WORLD_INDEX(x, y) (x + worldWidth * y)
 
+/// WorldView
+///  The tiles of the world the view can show, published after each frame's updates.
+struct WorldView
+{
+	/// Changes whenever the whole layer must be rendered again, such as when a level is loaded
+	int generation;
+
+	/// Changes whenever a tile is set
+	int revision;
+
+	/// The size of the world grid
+	int worldWidth;
+	int worldHeight;
+
+	/// The window of cells held (in world grid coordinates), and their stored tiles in grid order
+	int firstX;
+	int firstY;
+	int columns;
+	int rows;
+	std::vector<uint8_t> tiles;
+};
+
 /// WorldComponent
 ///  Central class for all sky game components.
 class WorldComponent :
@@ -29,12 +56,32 @@ public:
 	///  @background The identifier for the game background image.
 	///  @width The width of the world grid.
 	///  @height The height of the world grid.
-	WorldComponent(int backgroundId, int width, int height)
+	WorldComponent(int backgroundId, int width, int height) :
+		tiles(GameConstants::LEVEL_TILE_EMPTY),
+		views(),
+		drawn()
 	{
 		background = backgroundId;
+		img_background = NULL;
+		sheet = NULL;
 		worldWidth = width;
 		worldHeight = height;
-		grid = new int[width * height];
+		tiles.setFlags(BLOCKS::BLOCK_FLAGS.flags, BLOCK_FLAG_BLOCKING);
+		tiles.reset(width, height, NULL);
+		focusX = 0;
+		focusY = 0;
+		spawnX = 0;
+		spawnY = 0;
+
+		layer = None;
+		tileLayer = None;
+		layerWidth = 0;
+		layerHeight = 0;
+		layerX = 0;
+		layerY = 0;
+		layerGeneration = -1;
+		generation = 0;
+		revision = 0;
 	}
 
 	/// Disposes of the SkyComponent instance.
@@ -43,65 +90,94 @@ public:
 	}
 
 	/// Overloaded. Draws the Displayable component to the screen.
+	///  The background and the tiles in view are cached in an off-screen layer that XInfo restores the back
+	///  buffer from, so only cells changed since the last frame are re-rendered and copied.  When the camera
+	///  scrolls, the layer is composed again from the background and a layer of the tiles alone.
 	virtual void draw(XInfo* xinfo, GameTime* gameTime)
 	{
-		Display* _display = xinfo->getDisplay();
-		GC _gc = xinfo->getGraphicContext();
-
-		//background (no need for clipmask)
-		XPutImage(_display, xinfo->getImageBuffer(), _gc, img_background, 0, 0,	0, 0, img_background->width, img_background->height);
+		renderLayer(xinfo);
+	}
 
-		//XSetClipMask(_display, _gc, img_mask);
-		xinfo->setMask(img_mask);	
-		for(int x = 0; x < worldWidth; x++)
+	/// Overloaded. Publishes the tiles the view can show and the level generation for drawing.
+	virtual void publish(int slot)
+	{
+		WorldView& view = views[slot];
+		view.generation = generation;
+		view.revision = revision;
+		view.worldWidth = worldWidth;
+		view.worldHeight = worldHeight;
+
+		// every cell the view can show until the next snapshot, wherever the camera is interpolated to
+		int left, top, right, bottom;
+		getCamera()->getStepBounds(&left, &top, &right, &bottom);
+
+		int blockWidth = getBlockWidth();
+		int blockHeight = getBlockHeight();
+		view.firstX = std::max(0, left / blockWidth);
+		view.firstY = std::max(0, worldHeight - 1 - (bottom - 1) / blockHeight);
+		int lastX = std::min(worldWidth - 1, (right - 1) / blockWidth);
+		int lastY = std::min(worldHeight - 1, worldHeight - 1 - top / blockHeight);
+		view.columns = std::max(0, lastX - view.firstX + 1);
+		view.rows = std::max(0, lastY - view.firstY + 1);
+
+		view.tiles.resize(view.columns * view.rows);
+		for(int y = 0; y < view.rows; y++)
 		{
-			int posx = getWorldX(x);
-			for(int y = 0; y < worldHeight; y++)
+			for(int x = 0; x < view.columns; x++)
 			{
-				if(getBlock(x, y) == BLOCK_EMPTY)
-				{
-					continue;
-				}
-
-				int posy = getWorldY(y);
-				int blockVal = getBlock(x, y);
-				
-				xinfo->draw(sheet, posx, posy, blockVal);
+				view.tiles[x + view.columns * y] = tiles.get(view.firstX + x, view.firstY + y);
 			}
 		}
-		
-		xinfo->clearMask();
-		XSetClipMask(_display, _gc, None);
 	}
 
 	/// Overloaded. Updates the Displable component based on recent changes.
+	///  Chunks of the level far from the focus are evicted; they are read from the level file again if needed.
 	virtual void update(XInfo* xinfo, GameTime* gameTime)
 	{
+		tiles.evict(focusX, focusY, GameConstants::WORLD_CHUNK_RADIUS);
 	}
 
 	/// Overloaded. Loads an asset that is needed for the component.
 	virtual void load(XInfo* xinfo)
 	{
-		const char* fileBackground = getWorldBackground(background);
-		bool success = xinfo->loadImage(fileBackground, &img_background);
-		if(!success)
+		if(img_background == NULL)
 		{
-			Logger::application_error(Logger::LOG_ASSETERROR);
+			loadBackground(xinfo, background);
 		}
 
-		success = xinfo->loadImage(Resources::ASSET_WORLDSHEET, &img_blocks, Resources::ASSET_WORLDSHEET_MASK, &img_mask);
+		bool success = xinfo->loadImage(Resources::ASSET_WORLDSHEET, &img_blocks, &img_mask);
 		if(!success)
 		{
 			Logger::application_error(Logger::LOG_ASSETERROR);
 		}
 
 		sheet = new Spritesheet(img_blocks, 5, 5, 1);
+		xinfo->upload(img_blocks);
+		updateCameraBounds();
+
+		layerWidth = xinfo->getImageWidth();
+		layerHeight = xinfo->getImageHeight();
+		layer = xinfo->createPixmap(layerWidth, layerHeight);
+		tileLayer = xinfo->createLayer(layerWidth, layerHeight);
+		xinfo->setBackdrop(layer);
+		invalidate();
 	}
 
 	/// Overloaded. Disposes all data that was loaded by this Displayable.
 	virtual void unload(XInfo* xinfo)
 	{
-		XDestroyImage(img_background);
+		xinfo->destroyImage(img_background);
+		xinfo->destroyImage(img_blocks);
+		xinfo->freePixmap(img_mask);
+		xinfo->setBackdrop(None);
+		xinfo->freePixmap(layer);
+		if(tileLayer != None)
+		{
+			xinfo->freePixmap(tileLayer);
+		}
+		img_background = NULL;
+		layer = None;
+		tileLayer = None;
 	}
 
 	/// Overloaded. Initializes required services and loads any non-graphics resources.
@@ -111,6 +187,24 @@ public:
 		availableObjects = 0;
 	}
 
+	/// Overloaded. Gets the name used to report the component.
+	virtual const char* getName(void)
+	{
+		return "World";
+	}
+
+	/// Overloaded. Gets the shared state read while updating.
+	virtual unsigned int getUpdateReads(void)
+	{
+		return GameConstants::ACCESS_WORLD;
+	}
+
+	/// Overloaded. Gets the shared state written while updating.
+	virtual unsigned int getUpdateWrites(void)
+	{
+		return GameConstants::ACCESS_WORLD;
+	}
+
 	/// Loads a background based on an id.
 	///  @xinfo The graphics information for game.
 	///  @id The background identifier id.
@@ -118,12 +212,28 @@ public:
 	{
 		background  = id;
 		const char* fileBackground = getWorldBackground(background);
+
+		// the previous background may own a shared memory segment, so it is released first
+		xinfo->destroyImage(img_background);
+		img_background = NULL;
+
 		bool success = xinfo->loadImage(fileBackground, &img_background);		
 		if(!success)
 		{
 			Logger::application_debug(Logger::LOG_ASSETERROR, fileBackground);
 			Logger::application_error(Logger::LOG_ERROR);
 		}
+		xinfo->upload(img_background);
+
+		invalidate();
+	}
+
+	/// Starts decoding a background on the background loader, so a later loadBackground does not block.
+	///  @xinfo The graphics information for game.
+	///  @id The background identifier id.
+	void prefetchBackground(XInfo* xinfo, int id)
+	{
+		xinfo->prefetchImage(getWorldBackground(id));
 	}
 
 	/// Returns the number of objectives remaining in the level.
@@ -155,7 +265,7 @@ public:
 	///  @returns The value at the specific grid point.
 	int getBlock(int x, int y)
 	{
-		return grid[getWorldIndex(x, y)];
+		return LevelFile::toBlock(tiles.get(x, y));
 	}
 
 	/// Returns the block value at the index.
@@ -163,7 +273,7 @@ public:
 	///  @returns The value at the specific grid point.
 	int getBlock(int index)
 	{
-		return grid[index];
+		return getBlock(index % worldWidth, index / worldWidth);
 	}
 
 	/// Returns the x-position of a column.
@@ -186,12 +296,12 @@ public:
 	///  @x The x-coordinate (in world grid coordinates) of the level.
 	///  @y The y-coordinate (in world grid coordinates) of the level.
 	///  @returns The rectangle bounds of a world block.
-	Rectangle* getWorldBlock(int x, int y)
+	Rectangle getWorldBlock(int x, int y)
 	{
 		float worldX = getWorldX(x);
 		float worldY = getWorldY(y);
 
-		return new Rectangle(worldX, worldY, worldWidth, worldHeight);
+		return Rectangle(worldX, worldY, getBlockWidth(), getBlockHeight());
 	}
 
 	/// Gets the width of the world grid.
@@ -228,7 +338,117 @@ public:
 	///  @returns True if the block specified by coordinates is solid; false otherwise.
 	bool isSolid(int x, int y)
 	{
-		return grid[getWorldIndex(x, y)] == BLOCK_EMPTY;
+		return getBlock(x, y) == BLOCK_EMPTY;
+	}
+
+	/// Gets which cells of a run in a row stop the player.  Cells outside the world always do, so callers
+	/// can query past the edges without checking them.
+	///  @x The x-coordinate (in world grid coordinates) of the first cell.
+	///  @y The y-coordinate (in world grid coordinates) of the cells.
+	///  @count The number of cells, at most 32.
+	///  @returns A bitmap with bit i set if cell (x + i, y) is blocking (BLOCK_FLAG_BLOCKING).
+	uint32_t getBlockingRow(int x, int y, int count)
+	{
+		return tiles.getFlagRow(x, y, count);
+	}
+
+	/// Moves a box horizontally until it reaches a blocking cell.  Every column the leading edge crosses is
+	/// tested, so a long step cannot pass through a wall.  Cells the box already overlaps are ignored.
+	///  @bounds The box (in world coordinates).
+	///  @distance The horizontal distance to move.
+	///  @returns The distance the box can move, towards 'distance' and no further.
+	float sweepX(const Rectangle& bounds, float distance)
+	{
+		if(distance == 0)
+		{
+			return 0;
+		}
+
+		float blockWidth = getBlockWidth();
+		int firstRow = worldHeight - 1 - (MATH::iceiling((bounds.getTop() + bounds.getHeight()) / getBlockHeight()) - 1);
+		int lastRow = worldHeight - 1 - MATH::ifloor(bounds.getTop() / getBlockHeight());
+
+		if(distance > 0)
+		{
+			float edge = bounds.getLeft() + bounds.getWidth();
+			int first = MATH::iceiling(edge / blockWidth);
+			int last = MATH::iceiling((edge + distance) / blockWidth) - 1;
+
+			for(int x = first; x <= last; x += SWEEP_RUN)
+			{
+				uint32_t blocking = getBlockingColumns(x, std::min<int>(SWEEP_RUN, last - x + 1), firstRow, lastRow);
+				if(blocking != 0)
+				{
+					return (x + __builtin_ctz(blocking)) * blockWidth - edge;
+				}
+			}
+		}
+		else
+		{
+			float edge = bounds.getLeft();
+			int first = MATH::ifloor(edge / blockWidth) - 1;
+			int last = MATH::ifloor((edge + distance) / blockWidth);
+
+			for(int x = first; x >= last; x -= SWEEP_RUN)
+			{
+				int count = std::min<int>(SWEEP_RUN, x - last + 1);
+				uint32_t blocking = getBlockingColumns(x - count + 1, count, firstRow, lastRow);
+				if(blocking != 0)
+				{
+					return (x - count + 1 + 31 - __builtin_clz(blocking) + 1) * blockWidth - edge;
+				}
+			}
+		}
+		return distance;
+	}
+
+	/// Moves a box vertically until it reaches a blocking cell, or lands on a platform.  Every row the leading
+	/// edge crosses is tested, so a long fall cannot pass through a floor.  Platforms only stop a box moving
+	/// down onto them.  Cells the box already overlaps are ignored.
+	///  @bounds The box (in world coordinates).
+	///  @distance The vertical distance to move, positive downwards.
+	///  @returns The distance the box can move, towards 'distance' and no further.
+	float sweepY(const Rectangle& bounds, float distance)
+	{
+		if(distance == 0)
+		{
+			return 0;
+		}
+
+		float blockHeight = getBlockHeight();
+		int firstColumn = MATH::ifloor(bounds.getLeft() / getBlockWidth());
+		int count = MATH::iceiling((bounds.getLeft() + bounds.getWidth()) / getBlockWidth()) - firstColumn;
+
+		if(distance > 0)
+		{
+			float edge = bounds.getTop() + bounds.getHeight();
+			int first = MATH::iceiling(edge / blockHeight);
+			int last = MATH::iceiling((edge + distance) / blockHeight) - 1;
+
+			for(int row = first; row <= last; row++)
+			{
+				int y = worldHeight - 1 - row;
+				if(getBlockingRow(firstColumn, y, count) != 0 || isPlatformRow(firstColumn, y, count))
+				{
+					return row * blockHeight - edge;
+				}
+			}
+		}
+		else
+		{
+			float edge = bounds.getTop();
+			int first = MATH::ifloor(edge / blockHeight) - 1;
+			int last = MATH::ifloor((edge + distance) / blockHeight);
+
+			for(int row = first; row >= last; row--)
+			{
+				if(getBlockingRow(firstColumn, worldHeight - 1 - row, count) != 0)
+				{
+					return (row + 1) * blockHeight - edge;
+				}
+			}
+		}
+		return distance;
 	}
 
 	/// Returns true if the value at specified grid coordinate is empty.
@@ -237,7 +457,7 @@ public:
 	///  @returns True if the block specified by coordinates is empty; false otherwise.
 	bool isEmpty(int x, int y)
 	{
-		return grid[getWorldIndex(x, y)] == BLOCK_EMPTY;
+		return getBlock(x, y) == BLOCK_EMPTY;
 	}
 
 	/// Sets the block at the specified grid position to the value.
@@ -246,30 +466,101 @@ public:
 	///  @val The value to set to the value.
 	void setBlock(int x, int y, int val)
 	{
-		int index = getWorldIndex(x, y);
-		int currVal = grid[index];
+		int currVal = getBlock(x, y);
 
-		if(!BLOCKS::isBlockObjective(currVal))
+		if(BLOCKS::isBlockObjective(currVal))
 		{
 			availableObjects--;
 		}
 
-		if(!BLOCKS::isBlockObjective(val))
+		if(BLOCKS::isBlockObjective(val))
 		{
 			availableObjects++;
 		}
 
-		grid[index] = val;
+		tiles.set(x, y, LevelFile::toTile(val));
+		revision++;
 	}
 
-	/// Sets all blocks to BLOCK_EMPTY.
-	void clear(void)
+	/// Replaces the world with a level.  The level stays mapped, and its tiles are read in a chunk at a time
+	/// as the player approaches them.
+	///  @filename The path of the level file.
+	///  @returns True if the level is valid, false otherwise.
+	bool loadLevel(const char* filename)
 	{
-		int count = worldWidth * worldHeight;
-		for(int i = 0; i < count; i++)
+		LevelFile opened;
+		if(!opened.open(filename) || !opened.validate())
 		{
-			grid[i] = BLOCK_EMPTY;
+			return false;
 		}
+
+		loadLevel(opened);
+		return true;
+	}
+
+	/// Replaces the world with a level that was already opened and validated, such as by a LevelLoader.  The
+	/// mapped levels are exchanged, so the level previously played is left in prepared.
+	///  @prepared The opened and validated level.
+	void loadLevel(LevelFile& prepared)
+	{
+		level.swap(prepared);
+
+		worldWidth = level.getWidth();
+		worldHeight = level.getHeight();
+		tiles.reset(worldWidth, worldHeight, level.getTiles());
+
+		background = level.getBackground();
+		availableObjects = level.getObjectiveCount();
+		totalObjectives = availableObjects;
+		spawnX = level.getSpawnX();
+		spawnY = level.getSpawnY();
+
+		updateCameraBounds();
+		invalidate();
+	}
+
+	/// Gets the background of the current level.
+	///  @returns The background identifier id.
+	int getBackground(void)
+	{
+		return background;
+	}
+
+	/// Moves the point the resident part of the level is kept around.
+	///  @x The x-coordinate (in world coordinates) of the focus, normally the player.
+	///  @y The y-coordinate (in world coordinates) of the focus.
+	void setFocus(float x, float y)
+	{
+		focusX = MATH::clamp((int)(x / getBlockWidth()), 0, worldWidth - 1);
+		focusY = MATH::clamp(worldHeight - 1 - (int)(y / getBlockHeight()), 0, worldHeight - 1);
+	}
+
+	/// Gets the memory held by the world's tiles.
+	///  @returns The size in bytes.
+	size_t getTileMemory(void)
+	{
+		return tiles.getMemoryUsage();
+	}
+
+	/// Gets the player's starting x-coordinate in the current level.
+	///  @returns The x-coordinate (in world coordinates).
+	int getSpawnX(void)
+	{
+		return spawnX;
+	}
+
+	/// Gets the player's starting y-coordinate in the current level.
+	///  @returns The y-coordinate (in world coordinates).
+	int getSpawnY(void)
+	{
+		return spawnY;
+	}
+
+	/// Sets all blocks to BLOCK_EMPTY.
+	void clear(void)
+	{
+		tiles.reset(worldWidth, worldHeight, NULL);
+		invalidate();
 	}
 
 	/// Returns the filepath of the background based on an ID.
@@ -288,6 +579,263 @@ public:
 	}
 
 private:
+	/// Sets the camera bounds to the size of the world, once the block size is known.
+	void updateCameraBounds(void)
+	{
+		if(sheet != NULL && getCamera() != NULL)
+		{
+			getCamera()->setBounds(worldWidth * getBlockWidth(), worldHeight * getBlockHeight());
+		}
+	}
+
+	/// The most columns tested at once by sweepX, one bit each.  An enumerator, so it is never odr-used and needs no
+	/// definition outside the class.
+	enum { SWEEP_RUN = 32 };
+
+	/// Gets which columns of a run are blocking in any of a range of rows.
+	uint32_t getBlockingColumns(int x, int count, int firstRow, int lastRow)
+	{
+		uint32_t blocking = 0;
+		for(int y = firstRow; y <= lastRow; y++)
+		{
+			blocking |= getBlockingRow(x, y, count);
+		}
+		return blocking;
+	}
+
+	/// Returns true if any cell of a run in a row is a platform.  The run must not hold blocking cells, so it
+	/// lies within the world.
+	bool isPlatformRow(int x, int y, int count)
+	{
+		for(int i = 0; i < count; i++)
+		{
+			if(BLOCKS::isBlockPlatform(getBlock(x + i, y)))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/// Marks the whole cached layer for re-rendering, from the next snapshot published.
+	void invalidate(void)
+	{
+		generation++;
+	}
+
+	/// Gets a cell of a published view.
+	///  @view The view.
+	///  @x The x-coordinate (in world grid coordinates) of the cell.
+	///  @y The y-coordinate (in world grid coordinates) of the cell.
+	///  @returns The stored tile, or -1 if the view does not hold the cell.
+	static int getViewTile(const WorldView& view, int x, int y)
+	{
+		x -= view.firstX;
+		y -= view.firstY;
+		if(x < 0 || y < 0 || x >= view.columns || y >= view.rows)
+		{
+			return -1;
+		}
+		return view.tiles[x + view.columns * y];
+	}
+
+	/// Draws the tiles of a view that overlap a region of the screen to the render target.  The sprite mask must
+	/// be set.
+	void renderTiles(XInfo* xinfo, const WorldView& view, int left, int top, int right, int bottom)
+	{
+		if(right <= left || bottom <= top)
+		{
+			return;
+		}
+
+		Camera* camera = getView();
+		int blockWidth = sheet->getSpriteWidth();
+		int blockHeight = sheet->getSpriteHeight();
+
+		int firstColumn = std::max(0, (camera->getX() + left) / blockWidth);
+		int lastColumn = std::min(view.worldWidth - 1, (camera->getX() + right - 1) / blockWidth);
+		int firstRow = std::max(0, (camera->getY() + top) / blockHeight);
+		int lastRow = std::min(view.worldHeight - 1, (camera->getY() + bottom - 1) / blockHeight);
+
+		for(int row = firstRow; row <= lastRow; row++)
+		{
+			int y = view.worldHeight - 1 - row;
+			for(int x = firstColumn; x <= lastColumn; x++)
+			{
+				int tile = getViewTile(view, x, y);
+				if(tile >= 0 && LevelFile::toBlock(tile) != BLOCK_EMPTY)
+				{
+					xinfo->draw(sheet, camera->toScreenX(x * blockWidth), camera->toScreenY(row * blockHeight), LevelFile::toBlock(tile));
+				}
+			}
+		}
+	}
+
+	/// Brings the cached layer up to date and copies what changed to the back buffer.  The tiles are also kept in a
+	/// layer of their own, scrolled with the camera so only the columns and rows it uncovers are rendered; as the
+	/// background stays fixed to the screen, a scroll then composes the cached layer from the two with two copies.
+	/// Cells set since the last frame are found by comparing the view with the snapshot the layers were last
+	/// rendered from, and only when a tile was set.  Without layers (as with the software compositor) the tiles
+	/// are rendered again whenever the camera moves.
+	void renderLayer(XInfo* xinfo)
+	{
+		const WorldView& view = views[getDrawSlot()];
+		Camera* camera = getView();
+		int dx = layerX - camera->getX();
+		int dy = layerY - camera->getY();
+		bool moved = dx != 0 || dy != 0;
+		bool full = view.generation != layerGeneration || std::abs(dx) >= layerWidth || std::abs(dy) >= layerHeight;
+
+		layerX = camera->getX();
+		layerY = camera->getY();
+		layerGeneration = view.generation;
+
+		int blockWidth = sheet->getSpriteWidth();
+		int blockHeight = sheet->getSpriteHeight();
+
+		dirtyCells.clear();
+		if(!full && view.revision != drawn.revision)
+		{
+			int firstColumn = std::max(0, layerX / blockWidth);
+			int lastColumn = std::min(view.worldWidth - 1, (layerX + layerWidth - 1) / blockWidth);
+			int firstRow = std::max(0, layerY / blockHeight);
+			int lastRow = std::min(view.worldHeight - 1, (layerY + layerHeight - 1) / blockHeight);
+
+			for(int row = firstRow; row <= lastRow; row++)
+			{
+				int y = view.worldHeight - 1 - row;
+				for(int x = firstColumn; x <= lastColumn; x++)
+				{
+					if(getViewTile(view, x, y) != getViewTile(drawn, x, y))
+					{
+						dirtyCells.push_back(x + view.worldWidth * y);
+					}
+				}
+			}
+		}
+
+		if(!full && !moved && dirtyCells.empty())
+		{
+			// the tiles set were out of view; they are drawn from the view when scrolled in
+			drawn.revision = view.revision;
+			return;
+		}
+
+		if(tileLayer != None)
+		{
+			xinfo->setRenderTarget(tileLayer);
+			if(full)
+			{
+				xinfo->clearLayer(tileLayer);
+			}
+			else if(moved)
+			{
+				xinfo->scrollLayer(tileLayer, dx, dy);
+			}
+
+			xinfo->setMask(img_mask);
+			if(full)
+			{
+				renderTiles(xinfo, view, 0, 0, layerWidth, layerHeight);
+			}
+			else
+			{
+				// the columns and rows scrolled into view
+				renderTiles(xinfo, view, dx > 0 ? 0 : layerWidth + dx, 0, dx > 0 ? dx : layerWidth, layerHeight);
+				renderTiles(xinfo, view, 0, dy > 0 ? 0 : layerHeight + dy, layerWidth, dy > 0 ? dy : layerHeight);
+
+				for(size_t i = 0; i < dirtyCells.size(); i++)
+				{
+					int x = dirtyCells[i] % view.worldWidth;
+					int y = dirtyCells[i] / view.worldWidth;
+					int posx = camera->toScreenX(x * blockWidth);
+					int posy = camera->toScreenY((view.worldHeight - 1 - y) * blockHeight);
+					xinfo->clearLayer(tileLayer, posx, posy, blockWidth, blockHeight);
+
+					int tile = getViewTile(view, x, y);
+					if(tile >= 0 && LevelFile::toBlock(tile) != BLOCK_EMPTY)
+					{
+						xinfo->draw(sheet, posx, posy, LevelFile::toBlock(tile));
+					}
+				}
+			}
+			xinfo->clearMask();
+			xinfo->resetRenderTarget();
+		}
+
+		xinfo->setRenderTarget(layer);
+
+		if(full || moved)
+		{
+			// the background stays fixed to the screen while the tiles scroll over it
+			xinfo->draw(0, 0, 0, 0, img_background->width, img_background->height, img_background, None);
+
+			if(tileLayer != None)
+			{
+				xinfo->drawLayer(tileLayer, 0, 0);
+			}
+			else
+			{
+				xinfo->setMask(img_mask);
+				renderTiles(xinfo, view, 0, 0, layerWidth, layerHeight);
+				xinfo->clearMask();
+			}
+		}
+		else
+		{
+			for(size_t i = 0; i < dirtyCells.size(); i++)
+			{
+				int x = dirtyCells[i] % view.worldWidth;
+				int y = dirtyCells[i] / view.worldWidth;
+				int posx = camera->toScreenX(x * blockWidth);
+				int posy = camera->toScreenY((view.worldHeight - 1 - y) * blockHeight);
+
+				// restore the background under the cell, then the block over it
+				int left = std::max(0, posx);
+				int top = std::max(0, posy);
+				int width = std::min(posx + blockWidth, img_background->width) - left;
+				int height = std::min(posy + blockHeight, img_background->height) - top;
+				if(width > 0 && height > 0)
+				{
+					xinfo->draw(left, top, left, top, width, height, img_background, None);
+				}
+
+				int tile = getViewTile(view, x, y);
+				if(tile >= 0 && LevelFile::toBlock(tile) != BLOCK_EMPTY)
+				{
+					xinfo->setMask(img_mask);
+					xinfo->draw(sheet, posx, posy, LevelFile::toBlock(tile));
+					xinfo->clearMask();
+				}
+			}
+		}
+
+		xinfo->resetRenderTarget();
+
+		if(full || moved)
+		{
+			xinfo->copyArea(layer, 0, 0, layerWidth, layerHeight, 0, 0);
+		}
+		else
+		{
+			for(size_t i = 0; i < dirtyCells.size(); i++)
+			{
+				int posx = camera->toScreenX((dirtyCells[i] % view.worldWidth) * blockWidth);
+				int posy = camera->toScreenY((view.worldHeight - 1 - dirtyCells[i] / view.worldWidth) * blockHeight);
+
+				// only the part of the cell on screen is copied
+				int left = std::max(0, posx);
+				int top = std::max(0, posy);
+				int right = std::min(layerWidth, posx + blockWidth);
+				int bottom = std::min(layerHeight, posy + blockHeight);
+				xinfo->copyArea(layer, left, top, right - left, bottom - top, left, top);
+			}
+		}
+
+		// the copy reuses the storage of the last one
+		drawn = view;
+	}
+
 	///Graphics background
 	XImage* img_background;
 	int background;
@@ -304,5 +852,33 @@ private:
 	///Grid Components
 	int worldWidth;
 	int worldHeight;
-	int* grid;
+	TileMap tiles;
+
+	///The mapped level the tiles are read from, and the cell they are kept resident around
+	LevelFile level;
+	int focusX;
+	int focusY;
+
+	///Player starting position of the current level
+	int spawnX;
+	int spawnY;
+
+	///Bumped whenever the whole layer must be rendered again, and whenever a tile is set
+	int generation;
+	int revision;
+
+	///The tiles around the view, in the game's snapshot slots
+	WorldView views[Constants::TRIPLE_BUFFER_SLOTS];
+
+	///Cached background and tile layer, the layer of the tiles alone (None without layers), the camera position
+	///and snapshot they were rendered at, and the cells changed since
+	Pixmap layer;
+	Pixmap tileLayer;
+	int layerWidth;
+	int layerHeight;
+	int layerX;
+	int layerY;
+	int layerGeneration;
+	WorldView drawn;
+	std::vector<int> dirtyCells;
 };
@@ -1,3 +1,6 @@
+// The game is a single translation unit, so it owns the counting operator new (see lib/Allocations.h).
+#define XGAMELIB_COUNT_ALLOCATIONS
+
 #include <iostream>
 #include <list>
 #include <cstdlib>
@@ -13,12 +16,15 @@
 #include <X11/keysymdef.h>
 
 #include "lib/XInfo.h"
+#include "lib/HeadlessInfo.h"
 #include "lib/KeyboardState.h"
 #include "lib/MouseState.h"
 #include "lib/Displayable.h"
 #include "lib/Game.h"
 #include "lib/Constants.h"
 #include "lib/Logger.h"
+#include "lib/Allocations.h"
+#include "lib/HudLayer.h"
 
 #include "SkyComponent.h"
 #include "SkyComponent.h"
@@ -30,6 +36,19 @@
 
 using namespace std;
 
+/// MenuState
+///	 The pause menu and loading screen state drawn over the game, published after each frame's updates.
+struct MenuState
+{
+	bool paused;
+	bool shifting;
+
+	/// The reason for the level shift, when it started, and how much of the next level has loaded (in percent)
+	int shiftType;
+	unsigned long shiftStart;
+	int progress;
+};
+
 /// XPlatformer
 ///	 Game is the base class for an object that can be updated/drawn to the screen.  It includes
 ///  additional functionality such as initialize/load/unload for a self contained component.
@@ -38,7 +57,8 @@ class XPlatformer :
 {
 public:
 	/// Initializes a new instance of Game.
-	XPlatformer(void)
+	XPlatformer(void) :
+		menus()
 	{
 	}
 
@@ -52,13 +72,33 @@ public:
 	///  @gameTime Time elapsed since the last call to draw.
 	virtual void draw(XInfo* xinfo, GameTime* gameTime) 
 	{
+		const MenuState& menu = menus[getDrawSlot()];
+
 		// if in paused state, draw to screen and wait
-		if(isPaused)
+		if(menu.paused)
 		{
 			handleHaultMenu(xinfo, gameTime);
 		}
-		else
+		else if(menu.shifting)
 		{
+			drawLevelShift(xinfo, gameTime, menu);
+		}
+	}
+
+	/// Publishes the pause menu and loading screen state for drawing.
+	///  @slot The slot to fill.
+	virtual void publish(int slot)
+	{
+		MenuState& menu = menus[slot];
+		menu.paused = isPaused;
+		menu.shifting = isShifting;
+		menu.shiftType = shiftType;
+		menu.shiftStart = shiftStart;
+		menu.progress = 0;
+		if(isShifting)
+		{
+			int done = shiftTotal - std::min(shiftTotal, pendingAssets);
+			menu.progress = done * 100 / shiftTotal;
 		}
 	}
 
@@ -78,12 +118,14 @@ public:
 	///  @xinfo The graphics information for game.
 	virtual void load(XInfo* xinfo) 
 	{
+		loadHaultMenu(xinfo);
 	}
 
 	/// Disposes all data that was loaded by this Displayable.
 	///  @xinfo The graphics information for game.
 	virtual void unload(XInfo* xinfo)
 	{
+		pauseMenu.unload(xinfo);
 	}
 
 	/// Initializes required services and loads any non-graphics resources.
@@ -98,8 +140,13 @@ public:
 		addComponent(sky);
 		addComponent(world);
 
+		getCamera()->setDeadZone(GameConstants::CAMERA_DEAD_ZONE_WIDTH, GameConstants::CAMERA_DEAD_ZONE_HEIGHT);
+
 		world->clear();
 		Levels::setLevel(xinfo, *world, level);
+
+		// the next level is read and its assets decode while this one is played
+		Levels::prefetchLevel(xinfo, *world, nextLevel, getNextLevel());
 	}
 
 	/// Setting properties in the game.
@@ -137,12 +184,64 @@ public:
 			}
 
 			std::string param = cmdparam.substr (eq);
-			if(cmdparam.find("--fps=") == 0)
+			if(cmdparam.find("--profile=") == 0)
+			{
+				Constants::PROFILE_OUTPUT = argv[i] + eq;
+			}
+			else if(cmdparam.find("--fps=") == 0)
 			{			
 				int fpsvalue = atoi(param.c_str());
+				if(fpsvalue <= 0)
+				{
+					Logger::application_info(Logger::LOG_ARGNOTPOSITIVE, fpsvalue);
+					continue;
+				}
 				Constants::DEFAULT_FPS = fpsvalue;
 				Logger::application_info(Logger::INFO_FPS, fpsvalue);
 			}
+			else if(cmdparam.find("--shm=") == 0)
+			{
+				Constants::USE_SHM = atoi(param.c_str()) != 0;
+			}
+			else if(cmdparam.find("--damage=") == 0)
+			{
+				Constants::USE_DAMAGE = atoi(param.c_str()) != 0;
+			}
+			else if(cmdparam.find("--pack=") == 0)
+			{
+				Constants::ASSET_PACK = param == "0" ? NULL : argv[i] + eq;
+			}
+			else if(cmdparam.find("--compositor=") == 0)
+			{
+				Constants::USE_COMPOSITOR = atoi(param.c_str()) != 0;
+			}
+			else if(cmdparam.find("--xrender=") == 0)
+			{
+				Constants::USE_XRENDER = atoi(param.c_str()) != 0;
+			}
+			else if(cmdparam.find("--deadzone=") == 0)
+			{
+				sscanf(param.c_str(), "%fx%f", &GameConstants::CAMERA_DEAD_ZONE_WIDTH, &GameConstants::CAMERA_DEAD_ZONE_HEIGHT);
+			}
+			else if(cmdparam.find("--render-thread=") == 0)
+			{
+				Constants::USE_RENDER_THREAD = atoi(param.c_str()) != 0;
+			}
+			else if(cmdparam.find("--jobs=") == 0)
+			{
+				Constants::JOB_THREADS = atoi(param.c_str());
+			}
+			else if(cmdparam.find("--tick=") == 0)
+			{
+				int tickvalue = atoi(param.c_str());
+				if(tickvalue <= 0)
+				{
+					Logger::application_info(Logger::LOG_ARGNOTPOSITIVE, tickvalue);
+					continue;
+				}
+				Constants::DEFAULT_TICK_RATE = tickvalue;
+				Logger::application_info(Logger::INFO_TICK, tickvalue);
+			}
 			else
 			{
 				float value = atof(param.c_str());
@@ -187,9 +286,14 @@ public:
 		}
 
 		//if still running and conditions for new level met, move forward
-		if(isRunning() && (world->getObjectiveCount() == 0 || player->isDead()))
+		if(isRunning() && !isShifting && (world->getObjectiveCount() == 0 || player->isDead()))
+		{
+			beginLevelShift(xinfo, gameTime, player->isDead() ? 1 : 0);
+		}
+
+		if(isShifting)
 		{
-			handleLevelShift(xinfo, gameTime, player->isDead() ? 1 : 0);
+			handleLevelShift(xinfo, gameTime);
 		}
 	}
 
@@ -198,7 +302,26 @@ private:
 	PlayerComponent* player;
 	SkyComponent* sky;
 	int level = 0;
-	bool isPaused;
+	bool isPaused = false;
+
+	/// Loading screen state between levels
+	bool isShifting = false;
+	int shiftType = 0;
+	int shiftTotal = 0;
+	int pendingAssets = 0;
+	unsigned long shiftStart = 0;
+
+	/// The menu state drawn, in the game's snapshot slots
+	MenuState menus[Constants::TRIPLE_BUFFER_SLOTS];
+
+	/// The pause menu, which never changes, so it is rendered once
+	HudLayer pauseMenu;
+
+	/// Opens and validates the next level while this one is played
+	LevelLoader nextLevel;
+
+	/// The longest loading progress text, including the terminator
+	static const int PROGRESS_TEXT_LENGTH = 8;
 
 	/// Determines if the command is within the string.
 	///  @cmdparam The command parameter string.
@@ -209,112 +332,128 @@ private:
 		return cmdparam.find(value1)  == 0 || cmdparam.find(value2)  == 0;
 	}
 
-	/// Function to perform loading screen and level update.
-	void handleLevelShift(XInfo* xinfo, GameTime* gameTime, int type)
+	/// Returns the level that follows the current one.
+	int getNextLevel(void)
 	{
-		///Starts a loop that runs for X seconds (X wait intervals)
-		int waitCount = 3;
-		int increment = 0;
-		while(waitCount > 0)
-		{
-			//draw the screen
-			//draw(xinfo, gameTime);
-
-			//Draw a loading message over it
-			std::stringstream ss;
-			switch(type)
-			{
-			case 1:
-				ss << "You died ";
-				break;
-			default:
-				ss << "Loading next world ";
-				break;
-			}
-
-			for(int i = 0; i < increment; i++)
-			{
-				ss << ".";
-			}
-			std::string text = ss.str();
+		return level + 1 > Levels::getLevelCount() ? 1 : level + 1;
+	}
 
-			increment = (increment + 1) % 4;
+	/// Starts the loading screen.  The game keeps running while the next level's assets finish decoding.
+	///  @type The reason for the shift: 1 if the player died, 0 if the level was completed.
+	void beginLevelShift(XInfo* xinfo, GameTime* gameTime, int type)
+	{
+		isShifting = true;
+		shiftType = type;
+		shiftStart = gameTime->getTotalTime();
+
+		// normally already requested when the level started; this only queues it if it was not
+		Levels::prefetchLevel(xinfo, *world, nextLevel, getNextLevel());
+		pendingAssets = getPendingCount(xinfo);
+		shiftTotal = std::max(1, pendingAssets);
+	}
 
-			xinfo->drawString(text,
-				xinfo->getGraphicBounds()->getWidth() / 2 - 175,
-				160,
-				16766720);
+	/// Function to perform level update once the loading screen has been up long enough and the assets are ready.
+	void handleLevelShift(XInfo* xinfo, GameTime* gameTime)
+	{
+		float shown = (float)(gameTime->getTotalTime() - shiftStart) / Constants::NANOS_PER_SECOND;
+		pendingAssets = getPendingCount(xinfo);
+		if(shown < GameConstants::LEVEL_SHIFT_MIN_TIME || pendingAssets > 0)
+		{
+			return;
+		}
+		isShifting = false;
 
-			xinfo->flush();
+		{
+			// the old level and background are released, so the render thread must not be drawing with them;
+			// both were prepared in the background, so the lock is only held to swap them in
+			std::lock_guard<std::mutex> lock(getRenderLock());
 
-			//wait for a second to ensure slow 'loading' transition
-			xinfo->wait(1);
-			waitCount--;
+			level = getNextLevel();
+			Levels::setPrefetchedLevel(xinfo, *world, nextLevel, level);
+			Logger::application_info("Shifting to new level", level);
 		}
 
-		// resets the player
+		// resets the player to the new level's spawn point
 		player->reset();
 
-		//update level information
-		level = (level + 1);
-		if(level > LEVEL_COUNT)
-		{
-			level = 1;
-		}
+		Levels::prefetchLevel(xinfo, *world, nextLevel, getNextLevel());
+	}
 
-		Levels::setLevel(xinfo, *world, level);
-		Logger::application_info("Shifting to new level", level);
+	/// Gets the number of the next level's assets still being prepared: its decoding images and its level file.
+	int getPendingCount(XInfo* xinfo)
+	{
+		return xinfo->getPrefetchCount() + (nextLevel.isPending() ? 1 : 0);
 	}
 
-	/// Function for displaying pause menu information.
-	void handleHaultMenu(XInfo* xinfo, GameTime* gameTime)
+	/// Function to draw the loading screen message and the progress of the next level's assets.
+	void drawLevelShift(XInfo* xinfo, GameTime* gameTime, const MenuState& menu)
 	{
-		Display* _display = xinfo->getDisplay();
-		GC _gc = xinfo->getGraphicContext();
-		int _screen = xinfo->getScreen();
-		Pixmap _buffer = xinfo->getImageBuffer();
+		int increment = (int)((gameTime->getTotalTime() - menu.shiftStart) / (Constants::NANOS_PER_SECOND / 4)) % 4;
 
-		unsigned long black = BlackPixel(_display, _screen);
-		unsigned long white = WhitePixel(_display, _screen);
+		//Draw a loading message over it, built in the frame arena
+		ArenaAllocator<char> allocator(*getFrameArena());
+		ArenaString text(allocator);
+		switch(menu.shiftType)
+		{
+		case 1:
+			text = "You died ";
+			break;
+		default:
+			text = "Loading next world ";
+			break;
+		}
+		text.append(increment, '.');
 
-		//Sets colors and draw rectangle
-		XSetForeground(_display, _gc, black);
-		XSetBackground(_display, _gc, black);
-		XFillRectangle(_display, _buffer, _gc, 150, 25, 500, 200);
+		char* progress = getFrameArena()->allocateArray<char>(PROGRESS_TEXT_LENGTH);
+		snprintf(progress, PROGRESS_TEXT_LENGTH, "%d%%", menu.progress);
 
-		//set colour to white, draw inner rectangle
-		XSetForeground(_display, _gc, white);
-		XFillRectangle(_display, _buffer, _gc, 155, 30, 490, 190);
+		int x = xinfo->getGraphicBounds()->getWidth() / 2 - 175;
+		xinfo->drawString(text.c_str(), x, 160, 16766720);
+		xinfo->drawString(progress, x, 190, 16766720);
+	}
 
-		//draw a series of text within the rectangle
+	/// Function for building the pause menu layer.  Positions are relative to the menu at (150, 25).
+	void loadHaultMenu(XInfo* xinfo)
+	{
+		unsigned long black = ColorConstants::COLOR_BLACK;
+		unsigned long white = ColorConstants::COLOR_WHITE;
 
-		std::string infoTxt(Resources::ASSET_INFO_SPACE);
-		xinfo->drawString(infoTxt, 180, 70, black);
+		pauseMenu.load(xinfo, 500, 200);
 
-		std::string arrowTxt(Resources::ASSET_INFO_MOVEMENT);
-		xinfo->drawString(arrowTxt, 180, 120, black);
+		//black rectangle, with a white inner rectangle
+		pauseMenu.setRectangle(0, 0, 0, 500, 200, black);
+		pauseMenu.setRectangle(1, 5, 5, 490, 190, white);
 
-		std::string jumpTxt(Resources::ASSET_INFO_JUMP);
-		xinfo->drawString(jumpTxt, 180, 160, black);
+		//a series of text within the rectangle
+		pauseMenu.setString(2, Resources::ASSET_INFO_SPACE, 30, 45, black);
+		pauseMenu.setString(3, Resources::ASSET_INFO_MOVEMENT, 30, 95, black);
+		pauseMenu.setString(4, Resources::ASSET_INFO_JUMP, 30, 135, black);
+		pauseMenu.setString(5, Resources::ASSET_INFO_ACTION, 30, 175, black);
+	}
 
-		std::string actionTxt(Resources::ASSET_INFO_ACTION);
-		xinfo->drawString(actionTxt, 180, 200, black);
+	/// Function for displaying pause menu information, over everything else.
+	void handleHaultMenu(XInfo* xinfo, GameTime* gameTime)
+	{
+		pauseMenu.draw(xinfo, getCommandBuffer(), GameConstants::LAYER_HUD, 150, 25);
 	}
 };
 
 /*
 Entry point of the application.
-* Initializes the XInfo manager
 * Updates game by setting commands from command line
+* Initializes the XInfo manager (or the headless platform with --headless)
 * Runs the game
 */
 int main(int argc, char *argv[])
 {
-	XInfo* xinfo = new XInfo();
+	XInfo* xinfo = HeadlessInfo::isRequested(argc, argv) ? new HeadlessInfo() : new XInfo();
 	XPlatformer game;
 
+	// every component of the game draws from the snapshots it publishes
+	Constants::USE_RENDER_THREAD = true;
+
 	xinfo->setIcon(Resources::ASSET_ICON);
-	xinfo->initialize(argc, argv);
 	game.setByCommand(argc, argv);
+	xinfo->initialize(argc, argv);
 	game.run(xinfo);
 }
@@ -0,0 +1,235 @@
+/// Exports the built-in levels to the binary level format read by the game (see src/LevelFile.h).
+///
+/// Usage:
+///   exportlevels <output directory>
+///
+/// Writes level1.lvl, level2.lvl, ... to the directory.  The level layouts below were the game's hard-coded
+/// loaders; new levels are authored as files and do not need to be added here.
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "src/LevelFile.h"
+
+/// The size of the built-in levels (in tiles)
+static const int LEVEL_WIDTH = 12;
+static const int LEVEL_HEIGHT = 9;
+
+/// The player's starting position in the built-in levels (in world coordinates)
+static const int LEVEL_SPAWN_X = 10;
+static const int LEVEL_SPAWN_Y = 10;
+
+/// LevelBuilder
+///	 A level being laid out, with the subset of the WorldComponent interface the level layouts use.
+struct LevelBuilder
+{
+	LevelBuilder(int width, int height) :
+		tiles(width * height, GameConstants::LEVEL_TILE_EMPTY)
+	{
+		worldWidth = width;
+		worldHeight = height;
+		background = GameConstants::BG_GRASSLANDS;
+	}
+
+	int getWorldWidth(void)
+	{
+		return worldWidth;
+	}
+
+	int getWorldHeight(void)
+	{
+		return worldHeight;
+	}
+
+	void setBlock(int x, int y, int val)
+	{
+		tiles[x + worldWidth * y] = LevelFile::toTile(val);
+	}
+
+	int worldWidth;
+	int worldHeight;
+	int background;
+	std::vector<uint8_t> tiles;
+};
+
+/// Function used to define attributes of a level using the LevelBuilder. Specifically level one.
+///  @world The level being built.
+static void buildWorldOne(LevelBuilder& world)
+{
+	for(int x = 0; x < world.getWorldWidth(); x++)
+	{
+		if(x >= 3 && x <= 7)
+		{
+			world.setBlock(x, 1, BLOCK_BRIDGE);
+			world.setBlock(x, 0, BLOCK_WATER);
+
+			world.setBlock(x, 4, BLOCK_PLANK);
+		}
+		else
+		{
+			world.setBlock(x, 1, BLOCK_GRASS);
+			world.setBlock(x, 0, BLOCK_DEFAULT);
+		}
+	}
+
+	world.setBlock(3, 2, BLOCK_COIN_GOLD);
+	world.setBlock(7, 2, BLOCK_COIN_GOLD);
+
+	world.setBlock(5, 2, BLOCK_KEY_RED);
+	world.setBlock(9, 2, BLOCK_LOCK_RED); 
+
+	world.background = GameConstants::BG_GRASSLANDS;
+}
+
+/// Function used to define attributes of a level using the LevelBuilder. Specifically level two.
+///  @world The level being built.
+static void buildWorldTwo(LevelBuilder& world)
+{
+	int top = 3;
+	for(int x = 0; x < top; x++)
+	{
+		world.setBlock(0, x, BLOCK_ROCK);
+		world.setBlock(1, x, BLOCK_ROCK);
+
+		world.setBlock(world.getWorldWidth() - 1, x, BLOCK_ROCK);
+		world.setBlock(world.getWorldWidth() - 2, x, BLOCK_ROCK);
+	}
+
+	for(int x = 0; x < world.getWorldWidth(); x++)
+	{
+		if(x > 1 && x < world.getWorldWidth() - 2)
+		{
+			world.setBlock(x, 0, BLOCK_ROCK);
+			world.setBlock(x, 1, BLOCK_LAVA);
+		}
+
+		if (x < 4 || x > 6)
+		{
+			world.setBlock(x, top, BLOCK_ROCK);
+		}
+	}
+
+	world.setBlock(world.getWorldWidth() - 3, top + 1, BLOCK_COIN_GOLD);
+	world.setBlock(5, 3, BLOCK_COIN_GOLD);
+
+	world.background = GameConstants::BG_CASTLE;
+}
+
+/// Function used to define attributes of a level using the LevelBuilder. Specifically level three.
+///  @world The level being built.
+static void buildWorldThree(LevelBuilder& world)
+{
+	for(int x = 0; x < world.getWorldWidth(); x++)
+	{
+		world.setBlock(x, 0, BLOCK_DEFAULT);
+		world.setBlock(x, 1, BLOCK_SAND);
+	}
+
+	int platfrm = 5;
+	for(int x = 0; x < platfrm; x++)
+	{
+		world.setBlock(0, x, BLOCK_DEFAULT);
+	}
+	world.setBlock(0, platfrm, BLOCK_SAND);
+
+	int level1 = 5;
+	for(int x = 0; x < level1; x++)
+	{
+		world.setBlock(x + 4, platfrm, BLOCK_SAND);
+	}
+
+	for(int x = 0; x < 2; x++)
+	{
+		world.setBlock(x + 8, 2, BLOCK_SAND);
+		world.setBlock(x + 8, 1, BLOCK_DEFAULT);
+	}
+
+	for(int y = 0; y < 3; y++)
+	{
+		world.setBlock(10, y, BLOCK_DEFAULT);
+		world.setBlock(11, y, BLOCK_DEFAULT);
+	}
+	world.setBlock(10, 3, BLOCK_SAND);
+	world.setBlock(11, 3, BLOCK_SAND);
+
+	world.setBlock(5, platfrm + 1, BLOCK_KEY_BLUE);
+	world.setBlock(5, platfrm, BLOCK_LOCK_GREEN);
+
+	world.setBlock(5, 3, BLOCK_KEY_GREEN);
+	world.setBlock(5, 2, BLOCK_LOCK_BLUE);
+
+	world.background = GameConstants::BG_DESERT;
+}
+
+/// Writes a level to a file.
+static bool writeLevel(const LevelBuilder& world, const char* filename)
+{
+	LevelHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, GameConstants::LEVEL_MAGIC, sizeof(header.magic));
+	header.version = GameConstants::LEVEL_VERSION;
+	header.width = world.worldWidth;
+	header.height = world.worldHeight;
+	header.background = world.background;
+	header.spawnX = LEVEL_SPAWN_X;
+	header.spawnY = LEVEL_SPAWN_Y;
+	header.tileOffset = sizeof(LevelHeader);
+	header.fileSize = sizeof(LevelHeader) + world.tiles.size();
+
+	for(size_t i = 0; i < world.tiles.size(); i++)
+	{
+		if(BLOCKS::isBlockObjective(LevelFile::toBlock(world.tiles[i])))
+		{
+			header.objectiveCount++;
+		}
+	}
+
+	FILE* filePtr = fopen(filename, "wb");
+	if(filePtr == NULL)
+	{
+		return false;
+	}
+
+	fwrite(&header, sizeof(header), 1, filePtr);
+	fwrite(&world.tiles[0], 1, world.tiles.size(), filePtr);
+
+	bool failed = ferror(filePtr) != 0;
+	return fclose(filePtr) == 0 && !failed;
+}
+
+int main(int argc, char* argv[])
+{
+	if(argc != 2)
+	{
+		fprintf(stderr, "usage: exportlevels <output directory>\n");
+		return 1;
+	}
+
+	void (*levels[])(LevelBuilder&) = { buildWorldOne, buildWorldTwo, buildWorldThree };
+	int count = sizeof(levels) / sizeof(levels[0]);
+
+	for(int i = 0; i < count; i++)
+	{
+		LevelBuilder world(LEVEL_WIDTH, LEVEL_HEIGHT);
+		levels[i](world);
+
+		char filename[256];
+		snprintf(filename, sizeof(filename), "%s/level%d.lvl", argv[1], i + 1);
+		if(!writeLevel(world, filename))
+		{
+			fprintf(stderr, "exportlevels: unable to write: %s\n", filename);
+			return 1;
+		}
+
+		// the game refuses a level that does not validate, so check it the same way
+		LevelFile level;
+		if(!level.open(filename))
+		{
+			fprintf(stderr, "exportlevels: invalid level: %s\n", filename);
+			return 1;
+		}
+		printf("exportlevels: %s (%dx%d, %d objectives)\n", filename, level.getWidth(), level.getHeight(), level.getObjectiveCount());
+	}
+	return 0;
+}
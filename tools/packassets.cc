@@ -0,0 +1,175 @@
+/// Builds an asset pack from TGA images.  Each image is decoded once to the BGRA layout the game uploads,
+/// along with the clip mask derived from its alpha, so the game can map the pack and use the pixels as-is.
+///
+/// Usage:
+///   packassets <output.pack> <image.tga>...
+///
+/// Images are stored under the path they are given by, which must match the path the game loads them with.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <sys/stat.h>
+
+#include "lib/TgaDecoder.h"
+#include "lib/AssetPack.h"
+
+/// An image decoded for packing.
+struct PackedImage
+{
+	AssetPackEntry entry;
+	std::vector<char> pixels;
+	std::vector<unsigned char> mask;
+};
+
+/// Orders images by name, as the pack index is searched by name.
+static bool compareName(const PackedImage* a, const PackedImage* b)
+{
+	return strcmp(a->entry.name, b->entry.name) < 0;
+}
+
+/// Rounds an offset up to the pack alignment.
+static uint64_t align(uint64_t offset)
+{
+	uint64_t alignment = Constants::ASSET_PACK_ALIGNMENT;
+	return (offset + alignment - 1) / alignment * alignment;
+}
+
+/// Decodes an image and records the identity of its source file.
+static PackedImage* packImage(const char* filename)
+{
+	if(strlen(filename) >= sizeof(((AssetPackEntry*)NULL)->name))
+	{
+		fprintf(stderr, "packassets: path too long: %s\n", filename);
+		return NULL;
+	}
+
+	TgaDecoder decoder;
+	if(!decoder.open(filename))
+	{
+		fprintf(stderr, "packassets: unsupported image: %s\n", filename);
+		return NULL;
+	}
+
+	struct stat info;
+	uint64_t sourceHash;
+	if(stat(filename, &info) != 0 || !AssetPack::hashFile(filename, &sourceHash))
+	{
+		fprintf(stderr, "packassets: unable to read: %s\n", filename);
+		return NULL;
+	}
+
+	PackedImage* image = new PackedImage();
+	memset(&image->entry, 0, sizeof(image->entry));
+
+	AssetPackEntry& entry = image->entry;
+	strcpy(entry.name, filename);
+	entry.sourceHash = sourceHash;
+	entry.sourceSize = info.st_size;
+	entry.sourceTime = info.st_mtime;
+	entry.width = decoder.getWidth();
+	entry.height = decoder.getHeight();
+	entry.pixelStride = entry.width * 4;
+	entry.maskStride = (entry.width + 7) / 8;
+
+	image->pixels.resize((size_t)entry.pixelStride * entry.height);
+	if(!decoder.decode(&image->pixels[0], entry.pixelStride))
+	{
+		fprintf(stderr, "packassets: truncated image: %s\n", filename);
+		delete image;
+		return NULL;
+	}
+
+	image->mask.resize((size_t)entry.maskStride * entry.height);
+	TgaDecoder::getAlphaMask(&image->pixels[0], entry.pixelStride, entry.width, entry.height, &image->mask[0]);
+
+	return image;
+}
+
+/// Writes a block at an offset, padding the file up to it.
+static void writeAt(FILE* filePtr, uint64_t offset, const void* data, size_t length)
+{
+	static const char padding[Constants::ASSET_PACK_ALIGNMENT] = { 0 };
+	long position = ftell(filePtr);
+	fwrite(padding, 1, offset - position, filePtr);
+	fwrite(data, 1, length, filePtr);
+}
+
+int main(int argc, char* argv[])
+{
+	if(argc < 2)
+	{
+		fprintf(stderr, "usage: packassets <output.pack> <image.tga>...\n");
+		return 1;
+	}
+
+	std::vector<PackedImage*> images;
+	for(int i = 2; i < argc; i++)
+	{
+		PackedImage* image = packImage(argv[i]);
+		if(image == NULL)
+		{
+			return 1;
+		}
+		images.push_back(image);
+	}
+	std::sort(images.begin(), images.end(), compareName);
+
+	// lay out the header, the index, then each image's pixels and mask
+	uint64_t offset = sizeof(AssetPackHeader) + images.size() * sizeof(AssetPackEntry);
+	for(size_t i = 0; i < images.size(); i++)
+	{
+		AssetPackEntry& entry = images[i]->entry;
+		entry.pixelOffset = align(offset);
+		offset = entry.pixelOffset + images[i]->pixels.size();
+		entry.maskOffset = align(offset);
+		offset = entry.maskOffset + images[i]->mask.size();
+	}
+
+	AssetPackHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, Constants::ASSET_PACK_MAGIC, sizeof(header.magic));
+	header.version = Constants::ASSET_PACK_VERSION;
+	header.format = Constants::ASSET_PACK_FORMAT_BGRA32;
+	header.entryCount = images.size();
+	header.fileSize = offset;
+
+	// write to a temporary file so a failed build never leaves a truncated pack behind
+	std::string temporary = std::string(argv[1]) + ".tmp";
+	FILE* filePtr = fopen(temporary.c_str(), "wb");
+	if(filePtr == NULL)
+	{
+		fprintf(stderr, "packassets: unable to write: %s\n", temporary.c_str());
+		return 1;
+	}
+
+	fwrite(&header, sizeof(header), 1, filePtr);
+	for(size_t i = 0; i < images.size(); i++)
+	{
+		fwrite(&images[i]->entry, sizeof(AssetPackEntry), 1, filePtr);
+	}
+	for(size_t i = 0; i < images.size(); i++)
+	{
+		AssetPackEntry& entry = images[i]->entry;
+		writeAt(filePtr, entry.pixelOffset, &images[i]->pixels[0], images[i]->pixels.size());
+		writeAt(filePtr, entry.maskOffset, &images[i]->mask[0], images[i]->mask.size());
+	}
+
+	bool failed = ferror(filePtr) != 0;
+	failed = fclose(filePtr) != 0 || failed;
+	if(failed || rename(temporary.c_str(), argv[1]) != 0)
+	{
+		fprintf(stderr, "packassets: unable to write: %s\n", argv[1]);
+		remove(temporary.c_str());
+		return 1;
+	}
+
+	printf("packassets: %zu images, %llu bytes -> %s\n", images.size(), (unsigned long long)offset, argv[1]);
+	for(size_t i = 0; i < images.size(); i++)
+	{
+		delete images[i];
+	}
+	return 0;
+}